@@ -1,4 +1,4 @@
-__all__ = ['SortedList', 'SortedSet']
+__all__ = ['SortedList', 'SortedSet', 'SortedView', 'SortedDict']
 __version__ = '0.1'
 __author__ = 'Giorgio Vinciguerra'
 
@@ -6,5 +6,7 @@ import os as _os
 
 from .sortedlist import SortedList
 from .sortedset import SortedSet
+from .sortedview import SortedView
+from .sorteddict import SortedDict
 
 _os.environ['KMP_DUPLICATE_LIB_OK'] = 'True'
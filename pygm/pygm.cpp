@@ -1,9 +1,13 @@
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <numeric>
+#include <optional>
 #include <regex>
 #include <unordered_map>
 #include <vector>
@@ -13,6 +17,50 @@
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+/// An array of values of type T, converted from any sequence or array of numbers.
+template <typename T> using array_of = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
+/// Calls f, releasing the GIL if the number n of items it processes is large enough to pay off the release.
+template <typename F> void without_gil(size_t n, F f) {
+    if (n < 1ull << 15)
+        f();
+    else {
+        py::gil_scoped_release release;
+        f();
+    }
+}
+
+/// Calls f(i) for each i in [0, n), splitting the calls among the given number of threads if the module is compiled
+/// with OpenMP. Since f runs on other threads, the caller should release the GIL.
+template <typename F> void parallel_for(size_t n, int threads, F f) {
+    if (threads < 1)
+        throw std::invalid_argument("threads must be >= 1");
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(threads) if (threads > 1)
+#endif
+    for (int64_t i = 0; i < int64_t(n); ++i)
+        f(size_t(i));
+}
+
+/// Returns the n keys in x paired with their positions, sorted by key and then by position. Chunks of the keys are
+/// sorted and then merged using the given number of threads.
+template <typename K> std::vector<std::pair<K, size_t>> sorted_with_positions(const K *x, size_t n, int threads) {
+    std::vector<std::pair<K, size_t>> pairs(n);
+    for (size_t i = 0; i < n; ++i)
+        pairs[i] = {x[i], i};
+
+    auto chunks = size_t(std::max(threads, 1));
+    auto bound = [&](size_t t) { return pairs.begin() + n * std::min(t, chunks) / chunks; };
+    parallel_for(chunks, threads, [&](size_t t) { std::sort(bound(t), bound(t + 1)); });
+    for (size_t width = 1; width < chunks; width *= 2) {
+        parallel_for((chunks + 2 * width - 1) / (2 * width), threads, [&](size_t m) {
+            auto first = 2 * width * m;
+            std::inplace_merge(bound(first), bound(first + width), bound(first + 2 * width));
+        });
+    }
+    return pairs;
+}
+
 template <class InputIt1, class InputIt2, class OutputIt>
 OutputIt set_unique_union(InputIt1 first1, InputIt1 last1, InputIt2 first2, InputIt2 last2, OutputIt out) {
     for (; first1 != last1; ++out) {
@@ -82,27 +130,847 @@ bool set_unique_includes(InputIt1 first1, InputIt1 last1, InputIt2 first2, Input
     return true && is_proper;
 }
 
+/// A random-access iterator over a container whose elements are decoded on access, so it yields values rather than
+/// references. It allows the standard algorithms and the PGMWrapper queries to run on compressed storages.
+template <typename C> class IndexIterator {
+    const C *c = nullptr;
+    size_t i = 0;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename C::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = value_type;
+
+    IndexIterator() = default;
+
+    IndexIterator(const C *c, size_t i) : c(c), i(i) {}
+
+    reference operator*() const { return (*c)[i]; }
+
+    reference operator[](difference_type d) const { return (*c)[i + d]; }
+
+    IndexIterator &operator++() {
+        ++i;
+        return *this;
+    }
+
+    IndexIterator operator++(int) {
+        auto tmp = *this;
+        ++i;
+        return tmp;
+    }
+
+    IndexIterator &operator--() {
+        --i;
+        return *this;
+    }
+
+    IndexIterator operator--(int) {
+        auto tmp = *this;
+        --i;
+        return tmp;
+    }
+
+    IndexIterator &operator+=(difference_type d) {
+        i += d;
+        return *this;
+    }
+
+    IndexIterator &operator-=(difference_type d) {
+        i -= d;
+        return *this;
+    }
+
+    friend IndexIterator operator+(IndexIterator it, difference_type d) { return it += d; }
+
+    friend IndexIterator operator+(difference_type d, IndexIterator it) { return it += d; }
+
+    friend IndexIterator operator-(IndexIterator it, difference_type d) { return it -= d; }
+
+    friend difference_type operator-(const IndexIterator &a, const IndexIterator &b) {
+        return difference_type(a.i) - difference_type(b.i);
+    }
+
+    friend bool operator==(const IndexIterator &a, const IndexIterator &b) { return a.i == b.i; }
+
+    friend bool operator!=(const IndexIterator &a, const IndexIterator &b) { return a.i != b.i; }
+
+    friend bool operator<(const IndexIterator &a, const IndexIterator &b) { return a.i < b.i; }
+
+    friend bool operator>(const IndexIterator &a, const IndexIterator &b) { return a.i > b.i; }
+
+    friend bool operator<=(const IndexIterator &a, const IndexIterator &b) { return a.i <= b.i; }
+
+    friend bool operator>=(const IndexIterator &a, const IndexIterator &b) { return a.i >= b.i; }
+};
+
+/// Reads the width-bit value starting at the given bit offset of a packed array. The array must have a padding word.
+inline uint64_t read_bits(const uint64_t *words, size_t offset, uint8_t width) {
+    if (width == 0)
+        return 0;
+    auto word = offset / 64;
+    auto shift = offset % 64;
+    auto value = words[word] >> shift;
+    if (shift + width > 64)
+        value |= words[word + 1] << (64 - shift);
+    return width == 64 ? value : value & ((uint64_t(1) << width) - 1);
+}
+
+/// Writes the lowest width bits of value starting at the given bit offset of a zero-initialised packed array.
+inline void write_bits(uint64_t *words, size_t offset, uint8_t width, uint64_t value) {
+    if (width == 0)
+        return;
+    if (width < 64)
+        value &= (uint64_t(1) << width) - 1;
+    auto word = offset / 64;
+    auto shift = offset % 64;
+    words[word] |= value << shift;
+    if (shift + width > 64)
+        words[word + 1] |= value >> (64 - shift);
+}
+
+/// An Elias-Fano encoding of a non-decreasing sequence of integers. Each element takes 2 + log(u/n) bits, where u is
+/// the difference between the largest and the smallest element, and it is decoded in constant time via a sampled
+/// select on the upper bits.
+template <typename K> class EliasFano {
+    static_assert(std::is_integral_v<K>, "EliasFano requires integer keys");
+    static constexpr size_t select_sample = 256;
+
+    size_t n = 0;
+    K min_key = 0;
+    uint8_t low_bits = 0;
+    std::vector<uint64_t> lows;
+    std::vector<uint64_t> highs;
+    std::vector<size_t> samples; ///< The position in highs of every select_sample-th set bit.
+
+    size_t select1(size_t i) const {
+        auto pos = samples[i / select_sample];
+        auto rank = i % select_sample;
+        auto word_index = pos / 64;
+        auto word = highs[word_index] & (~uint64_t(0) << (pos % 64));
+        size_t ones;
+        while (rank >= (ones = __builtin_popcountll(word))) {
+            rank -= ones;
+            word = highs[++word_index];
+        }
+        for (; rank > 0; --rank)
+            word &= word - 1;
+        return word_index * 64 + __builtin_ctzll(word);
+    }
+
+  public:
+    using value_type = K;
+    using const_iterator = IndexIterator<EliasFano>;
+
+    EliasFano() = default;
+
+    explicit EliasFano(const std::vector<K> &keys) : n(keys.size()) {
+        if (n == 0)
+            return;
+
+        min_key = keys.front();
+        auto universe = uint64_t(keys.back()) - uint64_t(min_key);
+        low_bits = universe / n ? 63 - __builtin_clzll(universe / n) : 0;
+        lows.resize((n * low_bits + 63) / 64 + 1);
+        highs.resize((n + (universe >> low_bits) + 1 + 63) / 64 + 1);
+        samples.reserve(n / select_sample + 1);
+
+        for (size_t i = 0; i < n; ++i) {
+            auto x = uint64_t(keys[i]) - uint64_t(min_key);
+            auto pos = (x >> low_bits) + i;
+            write_bits(lows.data(), i * low_bits, low_bits, x);
+            highs[pos / 64] |= uint64_t(1) << (pos % 64);
+            if (i % select_sample == 0)
+                samples.push_back(pos);
+        }
+    }
+
+    K operator[](size_t i) const {
+        auto high = select1(i) - i;
+        auto x = (uint64_t(high) << low_bits) | read_bits(lows.data(), i * low_bits, low_bits);
+        return K(x + uint64_t(min_key));
+    }
+
+    size_t size() const { return n; }
+
+    size_t size_in_bytes() const {
+        return lows.size() * sizeof(uint64_t) + highs.size() * sizeof(uint64_t) + samples.size() * sizeof(size_t);
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, n}; }
+
+    bool operator==(const EliasFano &o) const {
+        return n == o.n && min_key == o.min_key && lows == o.lows && highs == o.highs;
+    }
+
+    bool operator!=(const EliasFano &o) const { return !(*this == o); }
+};
+
+/// A learned compression of a non-decreasing sequence of integers. The sequence is split at the boundaries of the
+/// leaf segments of a PGM-index, each segment is inverted to predict a key from its position, and the residuals of
+/// the keys from the predictions are bit-packed with a per-segment width. A key is decoded with a lookup in a
+/// position-sampled table of segments, a multiply-add and the unpacking of its residual.
+template <typename K> class ResidualStorage {
+    static_assert(std::is_integral_v<K>, "ResidualStorage requires integer keys");
+    static constexpr uint8_t block_bits = 6;
+
+    struct Model {
+        size_t start;          ///< The position of the first key predicted by the model.
+        size_t offset;         ///< The offset in bits of the residuals of the model.
+        K base;                ///< The first key predicted by the model.
+        double inverse_slope;  ///< The key increment per position.
+        uint64_t min_residual; ///< The smallest residual, which is subtracted before packing.
+        uint8_t width;         ///< The number of bits of each packed residual.
+    };
+
+    size_t n = 0;
+    std::vector<Model> models;
+    std::vector<uint32_t> blocks; ///< The model of every (1 << block_bits)-th position.
+    std::vector<uint64_t> residuals;
+
+    static uint64_t predict(double inverse_slope, size_t i) {
+        return uint64_t(std::min(inverse_slope * double(i), 18446744073709549568.0));
+    }
+
+    static uint8_t bit_width(uint64_t x) { return x ? 64 - __builtin_clzll(x) : 0; }
+
+  public:
+    using value_type = K;
+    using const_iterator = IndexIterator<ResidualStorage>;
+
+    ResidualStorage() = default;
+
+    /// Encodes the given sorted keys with the models given as pairs (first key, slope) of the leaf segments.
+    ResidualStorage(const std::vector<K> &keys, const std::vector<std::pair<K, double>> &leaf_models)
+        : n(keys.size()) {
+        if (n == 0)
+            return;
+
+        for (auto &[key, slope] : leaf_models) {
+            auto start = models.empty() ? 0 : size_t(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+            if (!models.empty() && start <= models.back().start)
+                continue;
+            if (start >= n)
+                break;
+            models.push_back({start, 0, keys[start], slope > 0 ? 1. / slope : 0., 0, 0});
+        }
+
+        size_t bits = 0;
+        for (size_t m = 0; m < models.size(); ++m) {
+            auto &model = models[m];
+            auto end = m + 1 < models.size() ? models[m + 1].start : n;
+            auto min_max = [&] {
+                __int128 lo = 0, hi = 0;
+                for (auto i = model.start; i < end; ++i) {
+                    auto diff = uint64_t(keys[i]) - uint64_t(model.base);
+                    auto r = __int128(diff) - __int128(predict(model.inverse_slope, i - model.start));
+                    lo = std::min(lo, r);
+                    hi = std::max(hi, r);
+                }
+                return std::make_pair(lo, hi);
+            };
+
+            auto [lo, hi] = min_max();
+            if (hi - lo > __int128(~uint64_t(0))) {
+                model.inverse_slope = 0;
+                std::tie(lo, hi) = min_max();
+            }
+            model.min_residual = uint64_t(lo);
+            model.width = bit_width(uint64_t(hi - lo));
+            model.offset = bits;
+            bits += model.width * (end - model.start);
+        }
+
+        residuals.resize(bits / 64 + 2);
+        for (size_t m = 0; m < models.size(); ++m) {
+            auto &model = models[m];
+            auto end = m + 1 < models.size() ? models[m + 1].start : n;
+            for (auto i = model.start; i < end; ++i) {
+                auto d = i - model.start;
+                auto r = uint64_t(keys[i]) - uint64_t(model.base) - predict(model.inverse_slope, d);
+                write_bits(residuals.data(), model.offset + d * model.width, model.width, r - model.min_residual);
+            }
+        }
+
+        blocks.reserve((n >> block_bits) + 1);
+        for (size_t b = 0, m = 0; (b << block_bits) < n; ++b) {
+            while (m + 1 < models.size() && models[m + 1].start <= (b << block_bits))
+                ++m;
+            blocks.push_back(uint32_t(m));
+        }
+    }
+
+    K operator[](size_t i) const {
+        size_t m = blocks[i >> block_bits];
+        while (m + 1 < models.size() && models[m + 1].start <= i)
+            ++m;
+        auto &model = models[m];
+        auto d = i - model.start;
+        auto r = read_bits(residuals.data(), model.offset + d * model.width, model.width);
+        return K(uint64_t(model.base) + predict(model.inverse_slope, d) + model.min_residual + r);
+    }
+
+    size_t size() const { return n; }
+
+    size_t size_in_bytes() const {
+        return models.size() * sizeof(Model) + blocks.size() * sizeof(uint32_t) + residuals.size() * sizeof(uint64_t);
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, n}; }
+
+    bool operator==(const ResidualStorage &o) const { return std::equal(begin(), end(), o.begin(), o.end()); }
+
+    bool operator!=(const ResidualStorage &o) const { return !(*this == o); }
+};
+
+/// A run-length encoding of a sorted sequence, which stores each distinct key once together with the number of
+/// elements up to the end of its run. The PGMWrapper indexes only the distinct keys and maps their positions to the
+/// positions in the sequence through these prefix counts, so the cost of the queries does not depend on the number of
+/// duplicates.
+template <typename K> class RunLengthStorage {
+    std::vector<K> keys;
+    std::vector<size_t> ends;
+
+  public:
+    using value_type = K;
+    using const_iterator = IndexIterator<RunLengthStorage>;
+
+    RunLengthStorage() = default;
+
+    explicit RunLengthStorage(const std::vector<K> &sorted) {
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            if (i == 0 || sorted[i] != sorted[i - 1]) {
+                keys.push_back(sorted[i]);
+                ends.push_back(i + 1);
+            } else
+                ++ends.back();
+        }
+        keys.shrink_to_fit();
+        ends.shrink_to_fit();
+    }
+
+    K operator[](size_t i) const { return keys[std::upper_bound(ends.begin(), ends.end(), i) - ends.begin()]; }
+
+    /// Returns the number of elements smaller than the j-th distinct key.
+    size_t prefix(size_t j) const { return j ? ends[j - 1] : 0; }
+
+    const std::vector<K> &distinct() const { return keys; }
+
+    size_t size() const { return ends.empty() ? 0 : ends.back(); }
+
+    size_t size_in_bytes() const { return keys.size() * sizeof(K) + ends.size() * sizeof(size_t); }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, size()}; }
+
+    bool operator==(const RunLengthStorage &o) const { return keys == o.keys && ends == o.ends; }
+
+    bool operator!=(const RunLengthStorage &o) const { return !(*this == o); }
+};
+
+/// A Roaring-style encoding of a set of 32-bit unsigned integers. Keys are grouped in chunks by their upper 16 bits
+/// and the lower 16 bits of each chunk are stored in the smallest of three containers: a sorted array for sparse
+/// chunks, a bitmap with sampled ranks for dense chunks, or a list of runs for chunks made of long intervals. Queries
+/// on bitmaps and runs compute the rank directly, while queries on arrays use the approximate position given by the
+/// PGM-index to narrow the binary search.
+template <typename K> class HybridStorage {
+    static_assert(std::is_same_v<K, uint32_t>, "HybridStorage requires 32-bit unsigned keys");
+    static constexpr size_t bitmap_words = 1024;
+    static constexpr size_t words_per_rank = 8;
+    static constexpr size_t bitmap_bytes = bitmap_words * 8 + bitmap_words / words_per_rank * 2;
+
+    enum class Kind : uint8_t { array, bitmap, run };
+
+    struct Chunk {
+        uint16_t high;    ///< The upper 16 bits shared by the keys in the chunk.
+        Kind kind;        ///< The container that stores the lower 16 bits of the keys.
+        size_t offset;    ///< The position of the container in lows (arrays and runs) or words (bitmaps).
+        size_t prefix;    ///< The number of keys in the previous chunks.
+        uint32_t size;    ///< The number of keys in the chunk.
+        uint32_t entries; ///< The number of runs, for run containers.
+    };
+
+    size_t n = 0;
+    std::vector<Chunk> chunks;
+    std::vector<uint16_t> lows;       ///< Array values, or (first, last, rank) triples of runs.
+    std::vector<uint64_t> words;      ///< Bitmap words.
+    std::vector<uint16_t> word_ranks; ///< For every words_per_rank bitmap words, the rank in its chunk.
+
+    size_t rank_in_chunk(const Chunk &c, uint16_t low, bool inclusive, size_t lo, size_t hi) const {
+        if (c.kind == Kind::array) {
+            auto first = lows.begin() + c.offset;
+            auto a = std::clamp<size_t>(PGM_SUB_EPS(lo, c.prefix), 0, c.size);
+            auto b = std::clamp<size_t>(PGM_SUB_EPS(hi, c.prefix), a, c.size);
+            auto it = inclusive ? std::upper_bound(first + a, first + b, low)
+                                : std::lower_bound(first + a, first + b, low);
+            return it - first;
+        }
+
+        if (c.kind == Kind::bitmap) {
+            auto limit = size_t(low) + inclusive;
+            if (limit == bitmap_words * 64)
+                return c.size;
+            auto word = limit / 64;
+            auto block = word / words_per_rank;
+            size_t rank = word_ranks[c.offset / words_per_rank + block];
+            for (auto w = block * words_per_rank; w < word; ++w)
+                rank += __builtin_popcountll(words[c.offset + w]);
+            if (limit % 64)
+                rank += __builtin_popcountll(words[c.offset + word] & ((uint64_t(1) << (limit % 64)) - 1));
+            return rank;
+        }
+
+        auto runs = lows.begin() + c.offset;
+        size_t lo_run = 0, hi_run = c.entries;
+        while (lo_run < hi_run) {
+            auto mid = (lo_run + hi_run) / 2;
+            if (runs[3 * mid] <= low)
+                lo_run = mid + 1;
+            else
+                hi_run = mid;
+        }
+        if (lo_run == 0)
+            return 0;
+        auto r = 3 * (lo_run - 1);
+        if (!inclusive && low == runs[r])
+            return runs[r + 2];
+        auto last = std::min<size_t>(runs[r + 1], inclusive ? low : low - 1);
+        return runs[r + 2] + last - runs[r] + 1;
+    }
+
+    const Chunk *find_chunk(uint16_t high) const {
+        auto it = std::lower_bound(chunks.begin(), chunks.end(), high,
+                                   [](const Chunk &c, uint16_t h) { return c.high < h; });
+        return it == chunks.end() ? nullptr : &*it;
+    }
+
+  public:
+    using value_type = K;
+    using const_iterator = IndexIterator<HybridStorage>;
+
+    HybridStorage() = default;
+
+    explicit HybridStorage(const std::vector<K> &keys) : n(keys.size()) {
+        for (size_t i = 0; i < n;) {
+            auto high = uint16_t(keys[i] >> 16);
+            auto j = i;
+            size_t runs = 0;
+            for (; j < n && (keys[j] >> 16) == high; ++j)
+                runs += j == i || keys[j] != keys[j - 1] + 1;
+
+            Chunk c{high, Kind::array, 0, i, uint32_t(j - i), 0};
+            auto array_bytes = c.size * 2;
+            auto run_bytes = runs * 6;
+            if (run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+                c.kind = Kind::run;
+                c.offset = lows.size();
+                c.entries = uint32_t(runs);
+                for (auto k = i; k < j; ++k) {
+                    auto low = uint16_t(keys[k]);
+                    if (k == i || keys[k] != keys[k - 1] + 1) {
+                        lows.push_back(low);
+                        lows.push_back(low);
+                        lows.push_back(uint16_t(k - i));
+                    } else
+                        lows[lows.size() - 2] = low;
+                }
+            } else if (bitmap_bytes < array_bytes) {
+                c.kind = Kind::bitmap;
+                c.offset = words.size();
+                words.resize(words.size() + bitmap_words);
+                for (auto k = i; k < j; ++k)
+                    words[c.offset + (keys[k] & 0xFFFF) / 64] |= uint64_t(1) << (keys[k] % 64);
+                size_t rank = 0;
+                for (size_t w = 0; w < bitmap_words; ++w) {
+                    if (w % words_per_rank == 0)
+                        word_ranks.push_back(uint16_t(rank));
+                    rank += __builtin_popcountll(words[c.offset + w]);
+                }
+            } else {
+                c.offset = lows.size();
+                for (auto k = i; k < j; ++k)
+                    lows.push_back(uint16_t(keys[k]));
+            }
+
+            chunks.push_back(c);
+            i = j;
+        }
+
+        chunks.shrink_to_fit();
+        lows.shrink_to_fit();
+    }
+
+    /// Returns the number of keys smaller than (or equal to, if inclusive) x. The function approx_range returns the
+    /// range of positions given by the PGM-index, and it is called only if x falls in an array container.
+    template <typename F> size_t rank(K x, bool inclusive, F approx_range) const {
+        auto c = find_chunk(uint16_t(x >> 16));
+        if (c == nullptr)
+            return n;
+        if (c->high != x >> 16)
+            return c->prefix;
+        size_t lo = 0, hi = n;
+        if (c->kind == Kind::array) {
+            ApproxPos range = approx_range();
+            lo = range.lo;
+            hi = range.hi;
+        }
+        return c->prefix + rank_in_chunk(*c, uint16_t(x), inclusive, lo, hi);
+    }
+
+    bool contains(K x) const {
+        auto c = find_chunk(uint16_t(x >> 16));
+        if (c == nullptr || c->high != x >> 16)
+            return false;
+        auto low = uint16_t(x);
+        if (c->kind == Kind::bitmap)
+            return words[c->offset + low / 64] >> (low % 64) & 1;
+        if (c->kind == Kind::array)
+            return std::binary_search(lows.begin() + c->offset, lows.begin() + c->offset + c->size, low);
+        return rank_in_chunk(*c, low, true, 0, 0) != rank_in_chunk(*c, low, false, 0, 0);
+    }
+
+    K operator[](size_t i) const {
+        auto c = std::prev(std::upper_bound(chunks.begin(), chunks.end(), i,
+                                            [](size_t i, const Chunk &c) { return i < c.prefix; }));
+        auto j = i - c->prefix;
+        auto high = K(c->high) << 16;
+
+        if (c->kind == Kind::array)
+            return high | lows[c->offset + j];
+
+        if (c->kind == Kind::bitmap) {
+            auto ranks = word_ranks.begin() + c->offset / words_per_rank;
+            auto block = std::upper_bound(ranks, ranks + bitmap_words / words_per_rank, j) - ranks - 1;
+            auto rank = j - ranks[block];
+            auto w = block * words_per_rank;
+            size_t ones;
+            while (rank >= (ones = __builtin_popcountll(words[c->offset + w]))) {
+                rank -= ones;
+                ++w;
+            }
+            auto word = words[c->offset + w];
+            for (; rank > 0; --rank)
+                word &= word - 1;
+            return high | K(w * 64 + __builtin_ctzll(word));
+        }
+
+        auto runs = lows.begin() + c->offset;
+        size_t lo_run = 0, hi_run = c->entries;
+        while (hi_run - lo_run > 1) {
+            auto mid = (lo_run + hi_run) / 2;
+            if (runs[3 * mid + 2] <= j)
+                lo_run = mid;
+            else
+                hi_run = mid;
+        }
+        return high | K(runs[3 * lo_run] + (j - runs[3 * lo_run + 2]));
+    }
+
+    size_t size() const { return n; }
+
+    size_t size_in_bytes() const {
+        return chunks.size() * sizeof(Chunk) + lows.size() * sizeof(uint16_t) + words.size() * sizeof(uint64_t) +
+               word_ranks.size() * sizeof(uint16_t);
+    }
+
+    /// Adds to the given stats the number of chunks of each kind.
+    void add_stats(std::unordered_map<std::string, size_t> &stats) const {
+        stats["array chunks"] = stats["bitmap chunks"] = stats["run chunks"] = 0;
+        for (auto &c : chunks)
+            ++stats[c.kind == Kind::array ? "array chunks" : c.kind == Kind::bitmap ? "bitmap chunks" : "run chunks"];
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, n}; }
+
+    bool operator==(const HybridStorage &o) const { return std::equal(begin(), end(), o.begin(), o.end()); }
+
+    bool operator!=(const HybridStorage &o) const { return !(*this == o); }
+};
+
+/// The type of the sums of keys of type K, which is wide enough to make them exact for integer keys.
+template <typename K>
+using SumOf = std::conditional_t<std::is_floating_point_v<K>, long double,
+                                 std::conditional_t<(sizeof(K) < 8), int64_t, __int128>>;
+
+/// A copy of the levels of a PGM-index in structure-of-arrays layout: the keys of the segments of each level are
+/// contiguous and are stored relative to the smallest key, while the slopes and the intercepts are kept in parallel
+/// arrays, so the search in a level touches only keys. Each level is padded with sentinels so that the search window
+/// is scanned with a fixed number of branch-free comparisons, which the compiler turns into SIMD instructions.
+///
+/// With single-precision slopes, the error introduced by the rounding is bounded for each level from the key range
+/// covered by its segments, and the search range of the level is widened by that bound, so that the guarantee on the
+/// maximum error still holds.
+template <typename K, typename Slope, size_t EpsilonRecursive> class SegmentLevels {
+    using Key =
+        typename std::conditional_t<std::is_integral_v<K>, std::make_unsigned<K>, std::enable_if<true, K>>::type;
+
+    /// The number of keys compared at once when searching a level, which covers the window of an exact level.
+    static constexpr size_t window = 2 * EpsilonRecursive + 8;
+
+    K base = 0;
+    std::vector<Key> keys;              ///< The keys of all the levels, leaf level first, each padded with sentinels.
+    std::vector<Slope> slopes;          ///< The slopes of the segments, aligned with keys.
+    std::vector<uint32_t> intercepts;   ///< The intercepts of the segments, aligned with keys.
+    std::vector<size_t> offsets;        ///< The offset of each level in keys.
+    std::vector<size_t> sizes;          ///< The number of segments of each level, excluding the sentinels.
+    std::vector<size_t> errors;         ///< The additional error of the predictions of each level due to the rounding.
+
+    Key to_key(K x) const {
+        if constexpr (std::is_integral_v<K>)
+            return Key(Key(x) - Key(base));
+        return x;
+    }
+
+    size_t predict(size_t i, Key k) const {
+        if (k <= keys[i])
+            return intercepts[i];
+        auto pos = int64_t(double(slopes[i]) * double(k - keys[i])) + intercepts[i];
+        return std::min<size_t>(pos > 0 ? size_t(pos) : 0, intercepts[i + 1]);
+    }
+
+    /// Returns the number of keys in [lo, hi) that are smaller than or equal to k, plus possibly some sentinels or keys
+    /// past hi that are larger than k.
+    size_t count_less_equal(size_t lo, size_t hi, Key k) const {
+        size_t count = 0;
+        for (; lo < hi; lo += window) {
+            auto first = keys.data() + lo;
+            for (size_t j = 0; j < window; ++j)
+                count += first[j] <= k;
+        }
+        return count;
+    }
+
+  public:
+    SegmentLevels() = default;
+
+    /// Copies the height levels of a PGM-index, given its segments, the height + 1 offsets delimiting the levels in
+    /// the segments, and the largest indexed key. Each level ends with a sentinel segment, which is not copied.
+    template <typename Segments>
+    SegmentLevels(const Segments &source, const std::vector<size_t> &levels_offsets, size_t height, K first_key,
+                  K last_key)
+        : base(first_key), errors(height) {
+        assert(height > 0 && levels_offsets.size() == height + 1 && levels_offsets.back() == source.size());
+        auto level_last_key = to_key(last_key);
+
+        for (size_t l = 0; l < height; ++l) {
+            auto begin = levels_offsets[l];
+            auto end = levels_offsets[l + 1];
+            assert(end >= begin + 2);
+            offsets.push_back(keys.size());
+            sizes.push_back(end - begin - 1);
+
+            for (auto i = begin; i + 1 < end; ++i) {
+                auto &s = source[i];
+                auto key = to_key(s.key);
+                keys.push_back(key);
+                slopes.push_back(Slope(s.slope));
+                intercepts.push_back(uint32_t(s.intercept));
+
+                auto drift = std::abs((long double) s.slope - (long double) Slope(s.slope));
+                if (drift > 0) {
+                    auto span = (long double) ((i + 2 < end ? to_key(source[i + 1].key) : level_last_key) - key);
+                    errors[l] = std::max(errors[l], size_t(std::ceil(drift * span)) + 1);
+                }
+            }
+
+            level_last_key = keys.back();
+            keys.insert(keys.end(), window, std::numeric_limits<Key>::max());
+            slopes.insert(slopes.end(), window, 0);
+            intercepts.insert(intercepts.end(), window, uint32_t(source[end - 1].intercept));
+        }
+    }
+
+    ApproxPos search(K x, size_t epsilon, size_t n) const {
+        auto k = to_key(x);
+        auto i = offsets.back();
+
+        for (auto l = int(offsets.size()) - 2; l >= 0; --l) {
+            auto pos = predict(i, k);
+            auto eps = EpsilonRecursive + errors[l + 1];
+            auto lo = offsets[l] + PGM_SUB_EPS(pos, eps + 1);
+            auto hi = offsets[l] + PGM_ADD_EPS(pos, eps, sizes[l]);
+            i = lo + std::max<size_t>(count_less_equal(lo, hi, k), 1) - 1;
+        }
+
+        auto pos = predict(i, k);
+        auto eps = epsilon + errors[0];
+        return {pos, PGM_SUB_EPS(pos, eps), PGM_ADD_EPS(pos, eps, n)};
+    }
+
+    bool empty() const { return offsets.empty(); }
+
+    size_t leaf_count() const { return sizes.empty() ? 0 : sizes[0]; }
+
+    /// Returns the first key, the slope and the intercept of the i-th segment of the leaf level.
+    std::tuple<K, double, size_t> leaf(size_t i) const {
+        if constexpr (std::is_integral_v<K>)
+            return {K(Key(keys[i] + Key(base))), double(slopes[i]), intercepts[i]};
+        else
+            return {keys[i], double(slopes[i]), intercepts[i]};
+    }
+
+    /// Returns the largest additional error of the predictions of the leaf level.
+    size_t leaf_error() const { return errors.empty() ? 0 : errors[0]; }
+
+    size_t size_in_bytes() const {
+        return keys.size() * (sizeof(Key) + sizeof(Slope) + sizeof(uint32_t)) +
+               (offsets.size() + sizes.size() + errors.size()) * sizeof(size_t);
+    }
+};
+
 #define IGNORED_PARAMETER 1
 #define EPSILON_RECURSIVE 4
 
-template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER, EPSILON_RECURSIVE, double> {
-    std::vector<K> data;
+template <typename K, typename Storage = std::vector<K>>
+class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER, EPSILON_RECURSIVE, double> {
+    static constexpr bool contiguous = std::is_same_v<Storage, std::vector<K>>;
+    static constexpr bool run_length = std::is_same_v<Storage, RunLengthStorage<K>>;
+    static constexpr bool hybrid = std::is_same_v<Storage, HybridStorage<K>>;
+    static constexpr bool byte_keys = sizeof(K) == 1;
+
+    Storage data;
     bool duplicates;
     size_t epsilon = 64;
+    bool quantized = false;
+
+    /// The copy of the levels of the index used by the queries in place of the segments of the PGM-index, if any, which
+    /// has single-precision slopes if quantized.
+    SegmentLevels<K, double, EPSILON_RECURSIVE> levels;
+    SegmentLevels<K, float, EPSILON_RECURSIVE> quantized_levels;
+
+    /// For 8-bit keys, the number of keys smaller than each value of the universe, which replaces the index in queries.
+    std::vector<size_t> rank_table = std::vector<size_t>(byte_keys ? 257 : 0);
+
+    /// For a container built from a column, the position in the column of each key.
+    std::vector<size_t> rows;
+
+    /// The sum of the keys before each position, which is computed by the first range aggregate query.
+    mutable std::vector<SumOf<K>> sums;
+
+    static size_t table_index(K x) { return size_t(int(x) - int(std::numeric_limits<K>::min())); }
+
+    void build_internal_pgm(std::vector<K> &&keys) {
+        if constexpr (hybrid) {
+            if (duplicates)
+                throw std::invalid_argument("hybrid storage requires distinct keys");
+        }
+        without_gil(keys.size(), [&] { build_and_store(std::move(keys)); });
+
+        if constexpr (byte_keys) {
+            std::fill(rank_table.begin(), rank_table.end(), 0);
+            for (auto it = begin(); it != end(); ++it)
+                ++rank_table[table_index(*it) + 1];
+            std::partial_sum(rank_table.begin(), rank_table.end(), rank_table.begin());
+        }
+    }
+
+    void build_and_store(std::vector<K> &&keys) {
+        if constexpr (run_length) {
+            data = Storage(keys);
+            build_index(data.distinct());
+        } else {
+            build_index(keys);
+            if constexpr (contiguous)
+                data = std::move(keys);
+            else if constexpr (std::is_constructible_v<Storage, const std::vector<K> &, const LeafModels &>)
+                data = Storage(keys, leaf_models());
+            else
+                data = Storage(keys);
+        }
+        copy_levels();
+    }
+
+    /// Whether the segments of the PGM-index are laid out as SegmentLevels expects: height() + 1 offsets, starting at
+    /// the leaf level and ending past the last segment, each level having at least a segment and a sentinel.
+    bool levels_layout_matches() const {
+        auto &offsets = this->levels_offsets;
+        auto height = this->height();
+        if (height == 0 || offsets.size() != height + 1 || offsets.front() != 0 ||
+            offsets.back() != this->segments.size())
+            return false;
+        for (size_t l = 0; l < height; ++l)
+            if (offsets[l + 1] < offsets[l] + 2)
+                return false;
+        return this->segment_for_key(this->first_key) == this->segments.begin();
+    }
+
+    /// Whether the models of the PGM-index may overflow on keys up to last_key: they take the difference of two keys
+    /// in the type of the keys, or in int if narrower, which overflows for signed keys further apart than its maximum.
+    bool models_overflow(K last_key) const {
+        if constexpr (std::is_integral_v<K> && std::is_signed_v<K> && sizeof(K) >= sizeof(int)) {
+            using U = std::make_unsigned_t<K>;
+            return U(U(last_key) - U(this->first_key)) > U(std::numeric_limits<K>::max());
+        } else
+            return false;
+    }
+
+    /// Replaces the segments of the PGM-index with a copy in structure-of-arrays layout, if the index is quantized or
+    /// if the models of the library would overflow on its keys, which the copy predicts from unsigned differences.
+    /// Otherwise, the queries use the segments of the library as they are. The index is also left as is if it has too
+    /// many keys for 32-bit intercepts or if its levels are not laid out as expected.
+    void copy_levels() {
+        auto last_key = this->n == 0 ? K() : *std::prev(end());
+        if (!quantized && !models_overflow(last_key))
+            return;
+        if (this->n == 0 || this->n >= std::numeric_limits<uint32_t>::max() || !levels_layout_matches()) {
+            quantized = false;
+            return;
+        }
+        auto height = this->height();
+        if (quantized)
+            quantized_levels = {this->segments, this->levels_offsets, height, this->first_key, last_key};
+        else
+            levels = {this->segments, this->levels_offsets, height, this->first_key, last_key};
+        decltype(this->segments)().swap(this->segments);
+    }
+
+    size_t leaf_count() const {
+        if (quantized)
+            return quantized_levels.leaf_count();
+        return levels.empty() ? this->segments_count() : levels.leaf_count();
+    }
 
-    void build_internal_pgm() {
-        this->n = size();
+    void build_index(const std::vector<K> &keys) {
+        this->n = keys.size();
         if (this->n == 0) {
             this->first_key = 0;
             return;
         }
-        this->first_key = data.front();
-        if (this->n < 1ull << 15)
-            this->build(begin(), end(), epsilon, EPSILON_RECURSIVE);
-        else {
-            py::gil_scoped_release release;
-            this->build(begin(), end(), epsilon, EPSILON_RECURSIVE);
-        }
+        this->first_key = keys.front();
+        this->build(keys.begin(), keys.end(), epsilon, EPSILON_RECURSIVE);
+    }
+
+    using LeafModels = std::vector<std::pair<K, double>>;
+
+    /// Returns the first key and the slope of each segment in the last level of the index.
+    LeafModels leaf_models() const {
+        LeafModels models;
+        if (this->n == 0)
+            return models;
+        models.reserve(this->segments_count());
+        auto it = this->segment_for_key(this->first_key);
+        for (size_t i = 0; i < this->segments_count(); ++i, ++it)
+            models.emplace_back(it->key, double(it->slope));
+        return models;
+    }
+
+    /// Returns the segment i of the last level of the index, from whichever copy of the levels is in use.
+    std::tuple<K, double, size_t> leaf_segment(size_t i) const {
+        if (quantized)
+            return quantized_levels.leaf(i);
+        if (!levels.empty())
+            return levels.leaf(i);
+        auto &s = *(this->segment_for_key(this->first_key) + i);
+        return {s.key, double(s.slope), size_t(s.intercept)};
     }
 
     static K implicit_cast(py::handle h) {
@@ -116,74 +984,97 @@ template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER,
     }
 
   public:
-    using iterator = typename std::vector<K>::iterator;
-    using const_iterator = typename std::vector<K>::const_iterator;
+    using const_iterator = typename Storage::const_iterator;
+    using Sum = SumOf<K>;
 
     PGMWrapper() = default;
 
-    PGMWrapper(const PGMWrapper &p, bool drop_duplicates, size_t epsilon) : epsilon(epsilon) {
+    PGMWrapper(const PGMWrapper &p, bool drop_duplicates, size_t epsilon) : epsilon(epsilon), quantized(p.quantized) {
         if (epsilon < 16)
             throw std::invalid_argument("epsilon must be >= 16");
 
         if (p.has_duplicates() && drop_duplicates) {
-            data.reserve(p.size());
-            std::unique_copy(p.begin(), p.end(), std::back_inserter(data));
-            data.shrink_to_fit();
+            std::vector<K> tmp;
+            tmp.reserve(p.size());
+            std::unique_copy(p.begin(), p.end(), std::back_inserter(tmp));
+            tmp.shrink_to_fit();
             duplicates = false;
-            build_internal_pgm();
+            build_internal_pgm(std::move(tmp));
             return;
         }
 
-        data = p.data;
         duplicates = p.duplicates;
+        rows = p.rows;
 
         if (p.get_epsilon() == epsilon) {
+            data = p.data;
             this->n = p.n;
             this->segments = p.segments;
             this->first_key = p.first_key;
             this->levels_sizes = p.levels_sizes;
             this->levels_offsets = p.levels_offsets;
+            levels = p.levels;
+            quantized_levels = p.quantized_levels;
+            rank_table = p.rank_table;
         } else {
-            build_internal_pgm();
+            build_internal_pgm(std::vector<K>(p.begin(), p.end()));
         }
     }
 
-    PGMWrapper(py::iterator it, size_t size_hint, bool drop_duplicates, size_t epsilon) : epsilon(epsilon) {
+    PGMWrapper(py::iterator it, size_t size_hint, bool drop_duplicates, size_t epsilon, bool quantize)
+        : epsilon(epsilon), quantized(quantize) {
         if (epsilon < 16)
             throw std::invalid_argument("epsilon must be >= 16");
 
-        auto sorted = true;
-        data.reserve(size_hint);
-        if (it != py::iterator::sentinel())
-            data.push_back(implicit_cast(*it++));
-        for (; it != py::iterator::sentinel(); ++it) {
-            auto x = implicit_cast(*it);
-            if (x < data.back())
-                sorted = false;
-            data.push_back(x);
-        }
-
-        if (!sorted)
-            std::sort(data.begin(), data.end());
+        auto tmp = to_sorted_vector(it, size_hint);
         if (drop_duplicates) {
-            data.erase(std::unique(data.begin(), data.end()), data.end());
+            tmp.erase(std::unique(tmp.begin(), tmp.end()), tmp.end());
             duplicates = false;
         } else
             duplicates = true;
 
-        data.shrink_to_fit();
-        build_internal_pgm();
+        tmp.shrink_to_fit();
+        build_internal_pgm(std::move(tmp));
+    }
+
+    PGMWrapper(std::vector<K> &&keys, bool duplicates, size_t epsilon, bool quantize = false)
+        : duplicates(duplicates), epsilon(epsilon), quantized(quantize) {
+        if (epsilon < 16)
+            throw std::invalid_argument("epsilon must be >= 16");
+        build_internal_pgm(std::move(keys));
     }
 
-    PGMWrapper(std::vector<K> &&data, bool duplicates, size_t epsilon)
-        : data(std::move(data)), duplicates(duplicates), epsilon(epsilon) {
+    /// Builds the container from the n keys of a column in any order, recording the position in the column of each key.
+    /// If drop_duplicates is true, only the last occurrence of each key in the column is kept.
+    PGMWrapper(const K *column, size_t n, bool drop_duplicates, size_t epsilon, bool quantize, int threads)
+        : epsilon(epsilon), quantized(quantize) {
         if (epsilon < 16)
             throw std::invalid_argument("epsilon must be >= 16");
-        build_internal_pgm();
+
+        std::vector<K> keys;
+        keys.reserve(n);
+        rows.reserve(n);
+        without_gil(n, [&] {
+            auto pairs = sorted_with_positions(column, n, threads);
+            for (size_t i = 0; i < n; ++i) {
+                if (drop_duplicates && i + 1 < n && pairs[i + 1].first == pairs[i].first)
+                    continue;
+                keys.push_back(pairs[i].first);
+                rows.push_back(pairs[i].second);
+            }
+        });
+        keys.shrink_to_fit();
+        rows.shrink_to_fit();
+        duplicates = std::adjacent_find(keys.begin(), keys.end()) != keys.end();
+        build_internal_pgm(std::move(keys));
     }
 
     ApproxPos search(const K &key) const {
         auto k = std::max(this->first_key, key);
+        if (quantized)
+            return quantized_levels.search(k, epsilon, this->n);
+        if (!levels.empty())
+            return levels.search(k, epsilon, this->n);
         auto it = this->segment_for_key(k);
         auto pos = std::min<size_t>((*it)(k), std::next(it)->intercept);
         auto lo = PGM_SUB_EPS(pos, epsilon);
@@ -191,18 +1082,60 @@ template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER,
         return {pos, lo, hi};
     }
 
+    /// Returns an approximation of the position of the first key not less than x, together with a range [lo, hi] that
+    /// contains the exact position, computed from the index alone without accessing the keys.
+    ApproxPos approx_rank(K x) const {
+        if constexpr (byte_keys) {
+            auto r = rank_table[table_index(x)];
+            return {r, r, r};
+        }
+        if (this->n == 0)
+            return {0, 0, 0};
+        auto range = search(x);
+        range.pos = std::clamp(range.pos, range.lo, range.hi);
+        if constexpr (run_length)
+            return {data.prefix(range.pos), data.prefix(range.lo), data.prefix(range.hi)};
+        return range;
+    }
+
     bool contains(K x) const {
+        if constexpr (byte_keys)
+            return rank_table[table_index(x)] != rank_table[table_index(x) + 1];
+        if constexpr (hybrid)
+            return data.contains(x);
         auto range = search(x);
+        if constexpr (run_length) {
+            auto &keys = data.distinct();
+            return std::binary_search(keys.begin() + range.lo, keys.begin() + range.hi, x);
+        }
         return std::binary_search(data.begin() + range.lo, data.begin() + range.hi, x);
     }
 
     const_iterator lower_bound(K x) const {
+        if constexpr (byte_keys)
+            return begin() + rank_table[table_index(x)];
+        if constexpr (hybrid)
+            return begin() + data.rank(x, false, [&] { return search(x); });
         auto range = search(x);
+        if constexpr (run_length) {
+            auto &keys = data.distinct();
+            auto j = std::lower_bound(keys.begin() + range.lo, keys.begin() + range.hi, x) - keys.begin();
+            return begin() + data.prefix(j);
+        }
         return std::lower_bound(data.begin() + range.lo, data.begin() + range.hi, x);
     }
 
     const_iterator upper_bound(K x) const {
+        if constexpr (byte_keys)
+            return begin() + rank_table[table_index(x) + 1];
+        if constexpr (hybrid)
+            return begin() + data.rank(x, true, [&] { return search(x); });
         auto range = search(x);
+        if constexpr (run_length) {
+            auto &keys = data.distinct();
+            auto j = std::upper_bound(keys.begin() + range.lo, keys.begin() + range.hi, x) - keys.begin();
+            return begin() + data.prefix(j);
+        }
         auto it = std::upper_bound(data.begin() + range.lo, data.begin() + range.hi, x);
         if (!duplicates)
             return it;
@@ -213,28 +1146,28 @@ template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER,
         return std::upper_bound(it + (step / 2), std::min(it + step, end()), x);
     }
 
-    template <typename O> PGMWrapper<K> *merge(const O &o, size_t o_size) const {
+    template <typename O> PGMWrapper *merge(const O &o, size_t o_size) const {
         return set_operation<std::merge>(o, o_size, size() + o_size, true);
     }
 
-    template <typename O> PGMWrapper<K> *set_difference(const O &o, size_t o_size) const {
+    template <typename O> PGMWrapper *set_difference(const O &o, size_t o_size) const {
         return set_operation<std::set_difference>(o, o_size, size(), false);
     }
 
-    template <typename O> PGMWrapper<K> *set_symmetric_difference(const O &o, size_t o_size) const {
+    template <typename O> PGMWrapper *set_symmetric_difference(const O &o, size_t o_size) const {
         return set_operation<set_unique_symmetric_difference>(o, o_size, size() + o_size, false);
     }
 
-    template <typename O> PGMWrapper<K> *set_union(const O &o, size_t o_size) const {
+    template <typename O> PGMWrapper *set_union(const O &o, size_t o_size) const {
         return set_operation<set_unique_union>(o, o_size, size() + o_size, false);
     }
 
-    template <typename O> PGMWrapper<K> *set_intersection(const O &o, size_t o_size) const {
+    template <typename O> PGMWrapper *set_intersection(const O &o, size_t o_size) const {
         assert(!has_duplicates()); // otherwise std::set_intersection may output duplicates
         return set_operation<std::set_intersection>(o, o_size, std::min(size(), o_size), false);
     }
 
-    template <bool Reverse> bool subset(const PGMWrapper<K> &q, size_t, bool proper) const {
+    template <bool Reverse> bool subset(const PGMWrapper &q, size_t, bool proper) const {
         if constexpr (Reverse)
             return set_unique_includes(begin(), end(), q.begin(), q.end(), proper);
         return set_unique_includes(q.begin(), q.end(), begin(), end(), proper);
@@ -247,45 +1180,111 @@ template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER,
         return set_unique_includes(tmp.begin(), tmp.end(), begin(), end(), proper);
     }
 
-    bool equal_to(const PGMWrapper<K> &q, size_t) const { return data == q.data; }
+    bool equal_to(const PGMWrapper &q, size_t) const { return data == q.data; }
 
-    bool equal_to(py::iterator it, size_t it_size_hint) const { return data == to_sorted_vector(it, it_size_hint); }
+    bool equal_to(py::iterator it, size_t it_size_hint) const {
+        auto tmp = to_sorted_vector(it, it_size_hint);
+        return std::equal(begin(), end(), tmp.begin(), tmp.end());
+    }
 
-    bool not_equal_to(const PGMWrapper<K> &q, size_t) const { return data != q.data; }
+    bool not_equal_to(const PGMWrapper &q, size_t) const { return !equal_to(q, 0); }
 
-    bool not_equal_to(py::iterator it, size_t it_size_hint) const { return data != to_sorted_vector(it, it_size_hint); }
+    bool not_equal_to(py::iterator it, size_t it_size_hint) const { return !equal_to(it, it_size_hint); }
 
     std::unordered_map<std::string, size_t> stats() const {
         std::unordered_map<std::string, size_t> stats;
         stats["epsilon"] = get_epsilon();
         stats["height"] = this->height();
-        stats["index size"] = this->size_in_bytes();
-        stats["data size"] = sizeof(K) * size() + sizeof(*this);
-        stats["leaf segments"] = this->segments_count();
+        stats["index size"] = this->size_in_bytes() + levels.size_in_bytes() + quantized_levels.size_in_bytes() +
+                              rank_table.size() * sizeof(size_t) + sums.size() * sizeof(Sum);
+        stats["data size"] = data_size_in_bytes() + rows.size() * sizeof(size_t) + sizeof(*this);
+        stats["leaf segments"] = leaf_count();
+        stats["quantized"] = quantized;
+        stats["quantization error"] = quantized_levels.leaf_error();
+        if constexpr (hybrid)
+            data.add_stats(stats);
         return stats;
     }
 
     K operator[](size_t i) const { return data[i]; }
 
+    /// Returns the prefix sums of the keys, computing them if this is the first call.
+    const std::vector<Sum> &prefix_sums() const {
+        if (sums.size() != size() + 1) {
+            sums.assign(1, 0);
+            sums.reserve(size() + 1);
+            for (auto it = begin(); it != end(); ++it)
+                sums.push_back(sums.back() + *it);
+        }
+        return sums;
+    }
+
+    /// Returns the sum of the keys at the positions in [i, j).
+    Sum sum(size_t i, size_t j) const { return prefix_sums()[j] - prefix_sums()[i]; }
+
     size_t size() const { return data.size(); }
 
+    /// Returns the first keys, the slopes and the intercepts of the segments in the last level of the index, which
+    /// form a piecewise linear approximation of the rank of the keys.
+    std::tuple<std::vector<K>, std::vector<double>, std::vector<size_t>> leaf_segments() const {
+        std::tuple<std::vector<K>, std::vector<double>, std::vector<size_t>> out;
+        auto &[keys, slopes, intercepts] = out;
+        auto count = this->n ? leaf_count() : 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto [key, slope, intercept] = leaf_segment(i);
+            keys.push_back(key);
+            slopes.push_back(slope);
+            intercepts.push_back(intercept);
+        }
+        return out;
+    }
+
     size_t get_epsilon() const { return epsilon; }
 
+    bool is_quantized() const { return quantized; }
+
+    /// Returns a read-only description of the keys at the positions in [first, last), which are exposed without a copy
+    /// via the buffer protocol.
+    py::buffer_info buffer_info(size_t first, size_t last) const {
+        static_assert(contiguous, "only an uncompressed array of keys can be exported");
+        return py::buffer_info(data.data() + first, {ssize_t(last - first)}, {ssize_t(sizeof(K))});
+    }
+
     bool has_duplicates() const { return duplicates; }
 
-    auto begin() { return data.begin(); }
+    bool has_row_ids() const { return !rows.empty() || size() == 0; }
+
+    /// Returns the position in the column the container was built from of the key at position i.
+    size_t row_id(size_t i) const { return rows[i]; }
 
-    auto end() { return data.end(); }
+    size_t data_size_in_bytes() const {
+        if constexpr (contiguous)
+            return sizeof(K) * size();
+        else
+            return data.size_in_bytes();
+    }
 
-    auto begin() const { return data.cbegin(); }
+    const_iterator begin() const { return data.begin(); }
 
-    auto end() const { return data.cend(); }
+    const_iterator end() const { return data.end(); }
 
   private:
+    using vector_iterator = typename std::vector<K>::const_iterator;
     using back_iterator = typename std::back_insert_iterator<std::vector<K>>;
-    using set_fun = back_iterator (*)(const_iterator, const_iterator, const_iterator, const_iterator, back_iterator);
+    using set_fun =
+        back_iterator (*)(vector_iterator, vector_iterator, vector_iterator, vector_iterator, back_iterator);
 
-    static std::vector<K> to_sorted_vector(py::iterator &it, size_t it_size_hint) {
+    /// Returns the keys of p as a vector, decoding them into the given buffer if they are stored compressed.
+    static const std::vector<K> &as_vector(const PGMWrapper &p, std::vector<K> &buffer) {
+        if constexpr (contiguous)
+            return p.data;
+        else {
+            buffer.assign(p.begin(), p.end());
+            return buffer;
+        }
+    }
+
+    static std::vector<K> to_sorted_vector(py::iterator &it, size_t it_size_hint) {
         std::vector<K> tmp;
         tmp.reserve(it_size_hint);
 
@@ -305,41 +1304,924 @@ template <typename K> class PGMWrapper : private PGMIndex<K, IGNORED_PARAMETER,
     }
 
     template <set_fun F>
-    PGMWrapper<K> *set_operation(py::iterator it, size_t it_size_hint, size_t size_hint,
-                                 bool generates_duplicates) const {
-        std::vector<K> out;
+    PGMWrapper *set_operation(py::iterator it, size_t it_size_hint, size_t size_hint, bool generates_duplicates) const {
+        std::vector<K> out, buffer;
         out.reserve(size_hint);
         auto tmp = to_sorted_vector(it, it_size_hint);
-        F(begin(), end(), tmp.begin(), tmp.end(), std::back_inserter(out));
+        auto &keys = as_vector(*this, buffer);
+        F(keys.begin(), keys.end(), tmp.begin(), tmp.end(), std::back_inserter(out));
         out.shrink_to_fit();
-        return new PGMWrapper<K>(std::move(out), generates_duplicates, epsilon);
+        return new PGMWrapper(std::move(out), generates_duplicates, epsilon, quantized);
     }
 
     template <set_fun F>
-    PGMWrapper<K> *set_operation(const PGMWrapper<K> &q, size_t, size_t size_hint, bool generates_duplicates) const {
-        std::vector<K> out;
+    PGMWrapper *set_operation(const PGMWrapper &q, size_t, size_t size_hint, bool generates_duplicates) const {
+        std::vector<K> out, buffer, q_buffer;
         out.reserve(size_hint);
-        F(begin(), end(), q.begin(), q.end(), std::back_inserter(out));
+        auto &keys = as_vector(*this, buffer);
+        auto &q_keys = as_vector(q, q_buffer);
+        F(keys.begin(), keys.end(), q_keys.begin(), q_keys.end(), std::back_inserter(out));
         out.shrink_to_fit();
-        return new PGMWrapper<K>(std::move(out), generates_duplicates, epsilon);
+        return new PGMWrapper(std::move(out), generates_duplicates, epsilon, quantized);
     }
 };
 
-template <typename K> void declare_class(py::module &m, const std::string &name) {
-    using PGM = PGMWrapper<K>;
-    py::class_<PGM>(m, name.c_str())
-        .def(py::init<>())
-        .def(py::init<const PGM &, bool, size_t>())
-        .def(py::init<py::iterator, size_t, bool, size_t>())
+/// A view of the elements of a PGMWrapper at the positions in [first, last). It shares the storage and the index of the
+/// wrapper, which must outlive it, so it takes constant space regardless of the number of elements.
+template <typename K, typename Storage> class PGMView {
+    using PGM = PGMWrapper<K, Storage>;
 
-        // sequence protocol
-        .def("__len__", &PGM::size)
+  public:
+    using const_iterator = typename PGM::const_iterator;
+
+  private:
+    const PGM *p;
+    size_t first;
+    size_t last;
+
+    const_iterator clamp(const_iterator it) const { return std::clamp(it, begin(), end()); }
+
+  public:
+    PGMView(const PGM &p, size_t first, size_t last) : p(&p), first(first), last(last) {}
+
+    /// Returns the view of the elements at the positions in [i, j) of this view.
+    PGMView view(size_t i, size_t j) const { return {*p, first + i, first + j}; }
+
+    const PGM &parent() const { return *p; }
+
+    bool contains(K x) const {
+        auto it = lower_bound(x);
+        return it < end() && *it == x;
+    }
+
+    const_iterator lower_bound(K x) const { return clamp(p->lower_bound(x)); }
+
+    ApproxPos approx_rank(K x) const {
+        auto range = p->approx_rank(x);
+        auto local = [&](size_t i) { return std::clamp(i, first, last) - first; };
+        return {local(range.pos), local(range.lo), local(range.hi)};
+    }
+
+    const_iterator upper_bound(K x) const { return clamp(p->upper_bound(x)); }
+
+    K operator[](size_t i) const { return (*p)[first + i]; }
+
+    const std::vector<typename PGM::Sum> &prefix_sums() const { return p->prefix_sums(); }
+
+    typename PGM::Sum sum(size_t i, size_t j) const { return p->sum(first + i, first + j); }
+
+    size_t size() const { return last - first; }
+
+    size_t get_epsilon() const { return p->get_epsilon(); }
+
+    bool is_quantized() const { return p->is_quantized(); }
+
+    py::buffer_info buffer_info() const { return p->buffer_info(first, last); }
+
+    bool has_row_ids() const { return p->has_row_ids(); }
+
+    size_t row_id(size_t i) const { return p->row_id(first + i); }
+
+    const_iterator begin() const { return p->begin() + first; }
+
+    const_iterator end() const { return p->begin() + last; }
+};
+
+/// Keys of 128 bits, such as UUIDs or pairs of 64-bit integers compared lexicographically. They are projected to 64
+/// bits by subtracting the first key and dropping the low bits that are not needed to tell the first and last apart.
+/// If Pairs is true, the keys are exposed to Python as tuples of two integers, otherwise as integers.
+template <bool Pairs> class WideKeys {
+  public:
+    using value_type = unsigned __int128;
+    using owned_type = value_type;
+
+  private:
+    std::vector<value_type> keys;
+    value_type first = 0;
+    value_type last = 0;
+    unsigned shift = 0;
+
+  public:
+    WideKeys() = default;
+
+    explicit WideKeys(const std::vector<value_type> &sorted) : keys(sorted) {
+        if (keys.empty())
+            return;
+        first = keys.front();
+        last = keys.back();
+        auto high = uint64_t((last - first) >> 64);
+        shift = high ? 64 - __builtin_clzll(high) : 0;
+    }
+
+    /// Returns a 64-bit integer that preserves the order of x with respect to the keys.
+    uint64_t project(value_type x) const { return uint64_t((std::clamp(x, first, last) - first) >> shift); }
+
+    value_type operator[](size_t i) const { return keys[i]; }
+
+    size_t size() const { return keys.size(); }
+
+    size_t size_in_bytes() const { return keys.size() * sizeof(value_type); }
+
+    bool operator==(const WideKeys &o) const { return keys == o.keys; }
+
+    /// Converts a tuple of two integers, an integer or 16 bytes in big-endian order to a key.
+    static value_type from_python(py::handle h) {
+        if (py::isinstance<py::bytes>(h)) {
+            auto s = h.cast<std::string>();
+            if (s.size() != sizeof(value_type))
+                throw py::value_error("expected 16 bytes, got " + std::to_string(s.size()));
+            value_type x = 0;
+            for (auto c : s)
+                x = (x << 8) | uint8_t(c);
+            return x;
+        }
+        if constexpr (Pairs) {
+            auto [high, low] = h.cast<std::pair<uint64_t, uint64_t>>();
+            return (value_type(high) << 64) | low;
+        }
+        return from_python(py::int_(h).attr("to_bytes")(sizeof(value_type), "big"));
+    }
+
+    static py::object to_python(value_type x) {
+        auto high = uint64_t(x >> 64);
+        auto low = uint64_t(x);
+        if constexpr (Pairs)
+            return py::make_tuple(high, low);
+        if (high == 0)
+            return py::int_(low);
+        return (py::int_(high) << py::int_(64)) | py::int_(low);
+    }
+};
+
+/// Byte strings, such as ticker symbols, hashes or ISO dates, stored one after the other in an arena together with the
+/// offset at which each one ends. They are projected to the 8 bytes that follow the prefix shared by the first and
+/// the last key, padded with zeros, so that keys with a long common prefix are still told apart by the projection.
+class ByteKeys {
+  public:
+    using value_type = std::string_view;
+    using owned_type = std::string;
+
+  private:
+    std::vector<char> arena;
+    std::vector<size_t> offsets = std::vector<size_t>(1);
+    std::string first;
+    std::string last;
+    size_t shared = 0;
+
+  public:
+    ByteKeys() = default;
+
+    template <typename T> explicit ByteKeys(const std::vector<T> &sorted) {
+        size_t total = 0;
+        for (auto &s : sorted)
+            total += s.size();
+        arena.reserve(total);
+        offsets.reserve(sorted.size() + 1);
+        for (auto &s : sorted) {
+            arena.insert(arena.end(), s.begin(), s.end());
+            offsets.push_back(arena.size());
+        }
+        if (sorted.empty())
+            return;
+        first = sorted.front();
+        last = sorted.back();
+        shared = std::mismatch(first.begin(), first.end(), last.begin(), last.end()).first - first.begin();
+    }
+
+    /// Returns a 64-bit integer that preserves the order of x with respect to the keys.
+    uint64_t project(value_type x) const {
+        x = std::clamp(x, value_type(first), value_type(last));
+        uint64_t p = 0;
+        for (auto i = shared; i < shared + 8; ++i)
+            p = (p << 8) | (i < x.size() ? uint8_t(x[i]) : 0);
+        return p;
+    }
+
+    value_type operator[](size_t i) const { return {arena.data() + offsets[i], offsets[i + 1] - offsets[i]}; }
+
+    size_t size() const { return offsets.size() - 1; }
+
+    size_t size_in_bytes() const {
+        return arena.size() + offsets.size() * sizeof(size_t) + first.size() + last.size();
+    }
+
+    bool operator==(const ByteKeys &o) const { return arena == o.arena && offsets == o.offsets; }
+
+    static owned_type from_python(py::handle h) {
+        if (!py::isinstance<py::bytes>(h))
+            throw py::type_error("expected bytes");
+        return h.cast<std::string>();
+    }
+
+    static py::object to_python(value_type x) { return py::bytes(x.data(), x.size()); }
+};
+
+/// A sorted container of keys that are not numbers, whose PGM-index is built on a 64-bit projection of the keys that
+/// preserves their order. Since distinct keys may have the same projection, the position returned by the index is
+/// refined by comparing the keys themselves. The Keys class stores the keys and defines the projection.
+template <typename Keys>
+class ProjectedWrapper : private PGMIndex<uint64_t, IGNORED_PARAMETER, EPSILON_RECURSIVE, double> {
+    using Key = typename Keys::value_type;
+    using Owned = typename Keys::owned_type;
+
+    Keys data;
+    bool duplicates = false;
+    size_t epsilon = 64;
+
+    void build_index(const std::vector<Key> &keys) {
+        without_gil(keys.size(), [&] {
+            data = Keys(keys);
+            std::vector<uint64_t> projections(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                projections[i] = data.project(data[i]);
+            this->n = projections.size();
+            this->first_key = this->n ? projections.front() : 0;
+            if (this->n)
+                this->build(projections.begin(), projections.end(), epsilon, EPSILON_RECURSIVE);
+        });
+    }
+
+    /// Returns the first position in [first, last) whose key does not satisfy the predicate, which must be true on a
+    /// prefix of the keys.
+    template <typename F> size_t partition_point(size_t first, size_t last, F less) const {
+        auto count = last - first;
+        while (count > 0) {
+            auto half = count / 2;
+            if (less(first + half)) {
+                first += half + 1;
+                count -= half + 1;
+            } else
+                count = half;
+        }
+        return first;
+    }
+
+    /// Returns the position of the first key greater than x if Upper is true, or not less than x otherwise. The index
+    /// gives a range around the first key whose projection is not less than that of x, which is searched if its end
+    /// is past the result, and otherwise followed by an exponential search over the keys with the same projection.
+    template <bool Upper> size_t bound(const Key &x) const {
+        if (this->n == 0)
+            return 0;
+        auto less = [&](size_t i) { return Upper ? !(x < data[i]) : data[i] < x; };
+        auto k = std::max(this->first_key, data.project(x));
+        auto it = this->segment_for_key(k);
+        auto pos = std::min<size_t>((*it)(k), std::next(it)->intercept);
+        auto lo = PGM_SUB_EPS(pos, epsilon);
+        auto hi = PGM_ADD_EPS(pos, epsilon, this->n);
+        if (hi == this->n || !less(hi))
+            return partition_point(lo, hi, less);
+
+        size_t step = 1;
+        while (hi + step < this->n && less(hi + step)) {
+            hi += step;
+            step *= 2;
+        }
+        return partition_point(hi + 1, std::min(hi + step, this->n), less);
+    }
+
+    std::vector<Key> keys() const {
+        std::vector<Key> out;
+        out.reserve(size());
+        for (size_t i = 0; i < size(); ++i)
+            out.push_back(data[i]);
+        return out;
+    }
+
+    static std::vector<Owned> to_sorted_vector(py::iterator &it, size_t it_size_hint) {
+        std::vector<Owned> tmp;
+        tmp.reserve(it_size_hint);
+        for (; it != py::iterator::sentinel(); ++it)
+            tmp.push_back(Keys::from_python(*it));
+        if (!std::is_sorted(tmp.begin(), tmp.end()))
+            std::sort(tmp.begin(), tmp.end());
+        return tmp;
+    }
+
+    using vector_iterator = typename std::vector<Key>::const_iterator;
+    using back_iterator = typename std::back_insert_iterator<std::vector<Key>>;
+    using set_fun =
+        back_iterator (*)(vector_iterator, vector_iterator, vector_iterator, vector_iterator, back_iterator);
+
+    template <set_fun F> ProjectedWrapper *set_operation(const std::vector<Key> &q_keys, bool duplicates) const {
+        std::vector<Key> out;
+        auto keys = this->keys();
+        F(keys.begin(), keys.end(), q_keys.begin(), q_keys.end(), std::back_inserter(out));
+        return new ProjectedWrapper(out, duplicates, epsilon);
+    }
+
+    template <set_fun F> ProjectedWrapper *set_operation(py::iterator it, size_t it_size_hint, bool duplicates) const {
+        auto tmp = to_sorted_vector(it, it_size_hint);
+        return set_operation<F>(std::vector<Key>(tmp.begin(), tmp.end()), duplicates);
+    }
+
+    template <set_fun F> ProjectedWrapper *set_operation(const ProjectedWrapper &q, size_t, bool duplicates) const {
+        return set_operation<F>(q.keys(), duplicates);
+    }
+
+  public:
+    using value_type = py::object;
+    using const_iterator = IndexIterator<ProjectedWrapper>;
+
+    ProjectedWrapper() = default;
+
+    ProjectedWrapper(const std::vector<Key> &keys, bool duplicates, size_t epsilon)
+        : duplicates(duplicates), epsilon(epsilon) {
+        if (epsilon < 16)
+            throw std::invalid_argument("epsilon must be >= 16");
+        build_index(keys);
+    }
+
+    ProjectedWrapper(const ProjectedWrapper &p, bool drop_duplicates, size_t epsilon) {
+        if (epsilon < 16)
+            throw std::invalid_argument("epsilon must be >= 16");
+        if (p.epsilon == epsilon && !(drop_duplicates && p.duplicates)) {
+            *this = p;
+            return;
+        }
+
+        this->epsilon = epsilon;
+        auto tmp = p.keys();
+        duplicates = p.duplicates && !drop_duplicates;
+        if (!duplicates)
+            tmp.erase(std::unique(tmp.begin(), tmp.end()), tmp.end());
+        build_index(tmp);
+    }
+
+    ProjectedWrapper(py::iterator it, size_t size_hint, bool drop_duplicates, size_t epsilon, bool)
+        : epsilon(epsilon) {
+        if (epsilon < 16)
+            throw std::invalid_argument("epsilon must be >= 16");
+        auto tmp = to_sorted_vector(it, size_hint);
+        if (drop_duplicates)
+            tmp.erase(std::unique(tmp.begin(), tmp.end()), tmp.end());
+        duplicates = !drop_duplicates;
+        build_index(std::vector<Key>(tmp.begin(), tmp.end()));
+    }
+
+    size_t lower_bound(const Key &x) const { return bound<false>(x); }
+
+    size_t upper_bound(const Key &x) const { return bound<true>(x); }
+
+    bool contains(const Key &x) const {
+        auto i = lower_bound(x);
+        return i < size() && !(x < data[i]);
+    }
+
+    /// Returns the key at position i without converting it to a Python object.
+    Key key(size_t i) const { return data[i]; }
+
+    py::object operator[](size_t i) const { return Keys::to_python(data[i]); }
+
+    size_t size() const { return data.size(); }
+
+    size_t get_epsilon() const { return epsilon; }
+
+    bool has_duplicates() const { return duplicates; }
+
+    template <typename O> ProjectedWrapper *merge(const O &o, size_t o_size) const {
+        return set_operation<std::merge>(o, o_size, true);
+    }
+
+    template <typename O> ProjectedWrapper *set_difference(const O &o, size_t o_size) const {
+        return set_operation<std::set_difference>(o, o_size, duplicates);
+    }
+
+    template <typename O> ProjectedWrapper *set_symmetric_difference(const O &o, size_t o_size) const {
+        return set_operation<set_unique_symmetric_difference>(o, o_size, false);
+    }
+
+    template <typename O> ProjectedWrapper *set_union(const O &o, size_t o_size) const {
+        return set_operation<set_unique_union>(o, o_size, false);
+    }
+
+    template <typename O> ProjectedWrapper *set_intersection(const O &o, size_t o_size) const {
+        return set_operation<std::set_intersection>(o, o_size, false);
+    }
+
+    template <bool Reverse> bool subset(const ProjectedWrapper &q, size_t, bool proper) const {
+        auto keys = this->keys(), q_keys = q.keys();
+        if constexpr (Reverse)
+            return set_unique_includes(keys.begin(), keys.end(), q_keys.begin(), q_keys.end(), proper);
+        return set_unique_includes(q_keys.begin(), q_keys.end(), keys.begin(), keys.end(), proper);
+    }
+
+    template <bool Reverse> bool subset(py::iterator it, size_t it_size_hint, bool proper) const {
+        auto keys = this->keys();
+        auto tmp = to_sorted_vector(it, it_size_hint);
+        if constexpr (Reverse)
+            return set_unique_includes(keys.begin(), keys.end(), tmp.begin(), tmp.end(), proper);
+        return set_unique_includes(tmp.begin(), tmp.end(), keys.begin(), keys.end(), proper);
+    }
+
+    bool equal_to(const ProjectedWrapper &q, size_t) const { return data == q.data; }
+
+    bool equal_to(py::iterator it, size_t it_size_hint) const {
+        auto keys = this->keys();
+        auto tmp = to_sorted_vector(it, it_size_hint);
+        return std::equal(keys.begin(), keys.end(), tmp.begin(), tmp.end());
+    }
+
+    bool not_equal_to(const ProjectedWrapper &q, size_t) const { return !equal_to(q, 0); }
+
+    bool not_equal_to(py::iterator it, size_t it_size_hint) const { return !equal_to(it, it_size_hint); }
+
+    std::unordered_map<std::string, size_t> stats() const {
+        std::unordered_map<std::string, size_t> stats;
+        stats["epsilon"] = epsilon;
+        stats["height"] = this->height();
+        stats["index size"] = this->size_in_bytes();
+        stats["data size"] = data.size_in_bytes() + sizeof(*this);
+        stats["leaf segments"] = this->segments_count();
+        stats["quantized"] = false;
+        stats["quantization error"] = 0;
+        return stats;
+    }
+
+    const_iterator begin() const { return {this, 0}; }
+
+    const_iterator end() const { return {this, size()}; }
+};
+
+/// The type of the scalar arguments of the queries on keys of type K. Integer keys narrower than 64 bits take int64_t
+/// arguments, so that values out of the range of K are valid arguments, as they are for the wider key types.
+template <typename K> using ProbeOf = std::conditional_t<std::is_integral_v<K> && (sizeof(K) < 8), int64_t, K>;
+
+/// Whether the query argument x is in the range of the keys of type K.
+template <typename K, typename P> bool in_key_range(P x) {
+    if constexpr (std::is_same_v<K, P>)
+        return true;
+    else
+        return x >= P(std::numeric_limits<K>::min()) && x <= P(std::numeric_limits<K>::max());
+}
+
+/// A number probed among the keys of type K, which may be out of their range or fall between two consecutive keys. Its
+/// floor and its ceiling are the largest key not larger than it and the smallest key not smaller than it, which are
+/// missing if it is smaller or larger than all the keys, and below and above are its distances from them. NaN has
+/// neither, and it is ordered after all the keys, as NumPy sorts it.
+template <typename K> struct KeyProbe {
+    std::optional<K> floor;
+    std::optional<K> ceil;
+    long double below = 0;
+    long double above = 0;
+    bool nan = false;
+
+    /// Whether the number equals a key, which is then both its floor and its ceiling.
+    bool exact() const { return floor && ceil && *floor == *ceil; }
+};
+
+/// Returns the number x probed among the keys of type K, comparing them exactly rather than casting x to K.
+template <typename K, typename T> KeyProbe<K> key_probe(T x) {
+    KeyProbe<K> p;
+    if constexpr (std::is_floating_point_v<T>) {
+        if (x != x) {
+            p.nan = true;
+            return p;
+        }
+    }
+
+    if constexpr (std::is_same_v<K, T>) {
+        p.floor = p.ceil = x;
+    } else if constexpr (std::is_floating_point_v<K>) {
+        // round x to a key, then step to the adjacent key on the other side of x if the rounding was inexact
+        K k;
+        int order;
+        if constexpr (std::is_floating_point_v<T>) {
+            auto huge = std::isfinite(x) && std::abs(x) > T(std::numeric_limits<K>::max());
+            k = huge ? std::copysign(std::numeric_limits<K>::infinity(), K(x > 0 ? 1 : -1)) : K(x);
+            order = T(k) < x ? -1 : T(k) > x;
+        } else {
+            // an integer rounds to an integral key, which is below 2^64 unless it is larger than x
+            k = K(x);
+            order = k >= std::ldexp(K(1), 64) ? 1 : (__int128) k < (__int128) x ? -1 : (__int128) k > (__int128) x;
+        }
+        constexpr auto infinity = std::numeric_limits<K>::infinity();
+        p.floor = order <= 0 ? k : std::nextafter(k, -infinity);
+        p.ceil = order >= 0 ? k : std::nextafter(k, infinity);
+        p.below = (long double) x - (long double) *p.floor;
+        p.above = (long double) *p.ceil - (long double) x;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        // the range of the keys is bounded by powers of two, which are exact in T
+        constexpr auto min = std::numeric_limits<K>::min();
+        constexpr auto max = std::numeric_limits<K>::max();
+        auto lo = std::is_signed_v<K> ? -std::ldexp(T(1), std::numeric_limits<K>::digits) : T(0);
+        auto hi = std::ldexp(T(1), std::numeric_limits<K>::digits);
+        if (x < lo) {
+            p.ceil = min;
+            p.above = (long double) min - (long double) x;
+        } else if (x >= hi) {
+            p.floor = max;
+            p.below = (long double) x - (long double) max;
+        } else {
+            auto f = std::floor(x), c = std::ceil(x);
+            p.floor = K(f);
+            p.below = x - f;
+            if (c < hi) {
+                p.ceil = K(c);
+                p.above = c - x;
+            }
+        }
+    } else {
+        constexpr auto min = std::numeric_limits<K>::min();
+        constexpr auto max = std::numeric_limits<K>::max();
+        auto v = (__int128) x;
+        if (v < min) {
+            p.ceil = min;
+            p.above = (long double) (min - v);
+        } else if (v > max) {
+            p.floor = max;
+            p.below = (long double) (v - max);
+        } else {
+            p.floor = p.ceil = K(x);
+        }
+    }
+    return p;
+}
+
+/// Returns the first element of c larger than the probe if Upper, or the first element not smaller than it otherwise.
+template <bool Upper, typename C, typename K> auto probe_bound(const C &c, const KeyProbe<K> &p) {
+    if (!Upper)
+        return p.ceil ? c.lower_bound(*p.ceil) : c.end();
+    if (p.floor)
+        return c.upper_bound(*p.floor);
+    return p.nan ? c.end() : c.begin();
+}
+
+/// Returns c.upper_bound(x) if Upper, or c.lower_bound(x) otherwise, for a query argument x that may be out of the
+/// range of the keys of type K or between two of them.
+template <bool Upper, typename K, typename C, typename P> auto probe_bound(const C &c, P x) {
+    return probe_bound<Upper>(c, key_probe<K>(x));
+}
+
+/// Returns c.approx_rank for the smallest key not smaller than the probe, or the exact position of the first element
+/// not smaller than it if the probe is out of the range of the keys.
+template <typename C, typename K> ApproxPos approx_rank(const C &c, const KeyProbe<K> &p) {
+    if (p.floor && p.ceil)
+        return c.approx_rank(*p.ceil);
+    auto rank = size_t(probe_bound<false>(c, p) - c.begin());
+    return {rank, rank, rank};
+}
+
+/// Returns the positions [i, j) of the elements of type K of c between a and b, where inclusive tells whether each
+/// bound is included.
+template <typename K, typename C, typename P>
+std::pair<size_t, size_t> range_positions(const C &c, P a, P b, std::pair<bool, bool> inclusive) {
+    auto first = inclusive.first ? probe_bound<false, K>(c, a) : probe_bound<true, K>(c, a);
+    auto last = inclusive.second ? probe_bound<true, K>(c, b) : probe_bound<false, K>(c, b);
+    auto i = size_t(first - c.begin());
+    return {i, std::max(i, size_t(last - c.begin()))};
+}
+
+/// Returns the number of elements of type K of c between a and b, where inclusive tells whether each bound is included.
+template <typename K, typename C, typename P>
+size_t count_range(const C &c, P a, P b, std::pair<bool, bool> inclusive) {
+    auto [i, j] = range_positions<K>(c, a, b, inclusive);
+    return j - i;
+}
+
+/// Returns the q-th quantile of the elements of c, interpolating linearly between the two closest elements.
+template <typename C> double quantile(const C &c, double q) {
+    auto h = q * double(c.size() - 1);
+    auto i = std::min(size_t(h), c.size() - 1);
+    auto lo = double(c[i]);
+    return i + 1 < c.size() ? lo + (h - double(i)) * (double(c[i + 1]) - lo) : lo;
+}
+
+/// Throws if c is empty or if some of the given quantiles are outside [0, 1].
+template <typename C> void check_quantiles(const C &c, const double *qs, size_t n) {
+    if (c.size() == 0)
+        throw std::invalid_argument("quantile of an empty container");
+    if (std::any_of(qs, qs + n, [](double q) { return !(q >= 0 && q <= 1); }))
+        throw std::invalid_argument("quantiles must be in the range [0, 1]");
+}
+
+/// Returns the fraction of the elements of c that are smaller than or equal to the probe, or an approximation of the
+/// fraction of those smaller than it computed from the index alone.
+template <typename C, typename K> double cdf(const C &c, const KeyProbe<K> &p, bool approximate) {
+    auto rank = approximate ? approx_rank(c, p).pos : size_t(probe_bound<true>(c, p) - c.begin());
+    return double(rank) / double(c.size());
+}
+
+/// The type of the distance between two keys of type K, which is unsigned for integer keys so that it never overflows.
+template <typename K>
+using DistanceOf =
+    typename std::conditional_t<std::is_integral_v<K>, std::make_unsigned<K>, std::enable_if<true, K>>::type;
+
+/// Returns the distance b - a between two keys a <= b.
+template <typename K> DistanceOf<K> key_distance(K a, K b) { return DistanceOf<K>(b) - DistanceOf<K>(a); }
+
+/// Returns x - d, or the smallest key if the result is not representable.
+template <typename K> K saturating_sub(K x, DistanceOf<K> d) {
+    if constexpr (std::is_integral_v<K>) {
+        constexpr auto min = std::numeric_limits<K>::min();
+        return key_distance(min, x) < d ? min : K(DistanceOf<K>(x) - d);
+    } else
+        return x - d;
+}
+
+/// Returns x + d, or the largest key if the result is not representable.
+template <typename K> K saturating_add(K x, DistanceOf<K> d) {
+    if constexpr (std::is_integral_v<K>) {
+        constexpr auto max = std::numeric_limits<K>::max();
+        return key_distance(x, max) < d ? max : K(DistanceOf<K>(x) + d);
+    } else
+        return x + d;
+}
+
+/// Returns the first position in [hint, c.end()) whose element is larger than x (or not smaller than x, if Upper is
+/// false), which is found by galloping from hint if it is within the given distance, and by the index otherwise.
+template <bool Upper, typename C, typename K>
+typename C::const_iterator bound_from(const C &c, typename C::const_iterator hint, K x, size_t distance) {
+    auto before = [&](K y) { return Upper ? !(x < y) : y < x; };
+    auto lo = hint;
+    for (size_t step = 1; step <= distance; step *= 2) {
+        if (size_t(c.end() - lo) <= step)
+            return std::partition_point(lo, c.end(), before);
+        if (!before(*(lo + step)))
+            return std::partition_point(lo, lo + step, before);
+        lo += step;
+    }
+    return Upper ? c.upper_bound(x) : c.lower_bound(x);
+}
+
+/// Returns whether none of the n probes returned by probe_at is NaN and their floors and ceilings are sorted, so that
+/// the bounds of each probe among the keys are not before those of the previous one.
+template <typename F> bool sorted_probes(size_t n, F probe_at) {
+    for (size_t i = 0; i < n; ++i) {
+        auto p = probe_at(i);
+        if (p.nan)
+            return false;
+        if (i == 0)
+            continue;
+        auto q = probe_at(i - 1);
+        if ((q.floor && (!p.floor || *p.floor < *q.floor)) || (p.ceil && (!q.ceil || *p.ceil < *q.ceil)))
+            return false;
+    }
+    return true;
+}
+
+/// Returns probe_bound<Upper>(c, p), which is found by galloping from hint as in bound_from.
+template <bool Upper, typename C, typename K>
+typename C::const_iterator probe_bound_from(const C &c, typename C::const_iterator hint, const KeyProbe<K> &p,
+                                            size_t distance) {
+    if (Upper ? !p.floor : !p.ceil)
+        return probe_bound<Upper>(c, p);
+    return bound_from<Upper>(c, hint, Upper ? *p.floor : *p.ceil, distance);
+}
+
+/// The distance between a probe and an element of type K, split into the distance between the element and the floor or
+/// the ceiling of the probe and the distance between the probe and that key, so that it is exact for integer keys.
+template <typename K> struct ProbeDistance {
+    DistanceOf<K> keys = 0;
+    long double excess = 0;
+
+    bool operator<(const ProbeDistance &other) const {
+        if constexpr (std::is_integral_v<K>)
+            return keys < other.keys || (keys == other.keys && excess < other.excess);
+        else
+            return keys + excess < other.keys + other.excess;
+    }
+
+    bool within(DistanceOf<K> tolerance) const {
+        if constexpr (std::is_integral_v<K>)
+            return keys <= tolerance && excess <= (long double) (tolerance - keys);
+        else
+            return keys + excess <= tolerance;
+    }
+};
+
+/// Writes the positions of the k elements of c closest to the probe, which must be at most as many as the elements,
+/// from the closest one and preferring the smaller element on ties.
+template <typename C, typename K> void nearest(const C &c, const KeyProbe<K> &p, size_t k, size_t *positions) {
+    auto right = size_t(probe_bound<false>(c, p) - c.begin());
+    auto left = right;
+    auto right_distance = [&] { return ProbeDistance<K>{key_distance(*p.ceil, c[right]), p.above}; };
+    auto left_distance = [&] { return ProbeDistance<K>{key_distance(c[left - 1], *p.floor), p.below}; };
+    for (size_t i = 0; i < k; ++i) {
+        auto take_right = left == 0 || (right < c.size() && right_distance() < left_distance());
+        positions[i] = take_right ? right++ : --left;
+    }
+}
+
+enum class AsofDirection { backward, forward, nearest };
+
+/// Matches each of the n values in x with the last element of c not larger than it (backward), the first element not
+/// smaller than it (forward), or the closest of the two (nearest, preferring backward on ties), provided that their
+/// distance is within the tolerance. Writes the positions of the matches, or -1 if there is none, and their keys. If
+/// the values are sorted, each search starts from the position of the previous match. The values are the n probes
+/// returned by probe_at.
+template <typename C, typename K, typename F>
+void asof(const C &c, size_t n, F probe_at, AsofDirection direction, std::optional<DistanceOf<K>> tolerance,
+          int64_t *positions, K *keys) {
+    auto gallop = sorted_probes(n, probe_at) ? 2 * c.get_epsilon() : 0;
+    auto lower = c.begin(), upper = c.begin();
+    for (size_t i = 0; i < n; ++i) {
+        positions[i] = -1;
+        keys[i] = K();
+        KeyProbe<K> probe = probe_at(i);
+        if (probe.nan)
+            continue;
+
+        std::optional<size_t> match;
+        ProbeDistance<K> distance;
+        if (direction != AsofDirection::forward) {
+            upper = probe_bound_from<true>(c, upper, probe, gallop);
+            if (upper != c.begin()) {
+                match = size_t(upper - c.begin()) - 1;
+                distance = {key_distance(c[*match], *probe.floor), probe.below};
+            }
+        }
+        if (direction != AsofDirection::backward) {
+            lower = probe_bound_from<false>(c, lower, probe, gallop);
+            if (lower != c.end()) {
+                ProbeDistance<K> forward = {key_distance(*probe.ceil, *lower), probe.above};
+                if (!match || forward < distance) {
+                    match = size_t(lower - c.begin());
+                    distance = forward;
+                }
+            }
+        }
+        if (match && (!tolerance || distance.within(*tolerance))) {
+            positions[i] = int64_t(*match);
+            keys[i] = c[*match];
+        }
+    }
+}
+
+/// Returns the largest distance between keys of type K not larger than d - excess, where excess <= d.
+template <typename K> DistanceOf<K> distance_within(DistanceOf<K> d, long double excess) {
+    if constexpr (std::is_integral_v<K>)
+        return d - DistanceOf<K>(std::ceil(excess));
+    else
+        return DistanceOf<K>(d - excess);
+}
+
+/// Writes the number of elements of c in [x - left, x + right] for each value x of the n probes returned by probe_at.
+/// If the values are sorted, the bounds of each window are searched from those of the previous one.
+template <typename K, typename C, typename F>
+void window_counts(const C &c, size_t n, F probe_at, DistanceOf<K> left, DistanceOf<K> right, size_t *counts) {
+    auto gallop = sorted_probes(n, probe_at) ? 2 * c.get_epsilon() : 0;
+    auto first = c.begin(), last = c.begin();
+    for (size_t i = 0; i < n; ++i) {
+        counts[i] = 0;
+        KeyProbe<K> p = probe_at(i);
+        if (p.nan)
+            continue;
+        // the window starts after the floor if the value is more than left past it, and symmetrically for the end
+        if (!p.floor)
+            first = c.begin();
+        else if (p.below > left)
+            first = probe_bound_from<true>(c, first, p, gallop);
+        else
+            first = bound_from<false>(c, first, saturating_sub(*p.floor, distance_within<K>(left, p.below)), gallop);
+        if (!p.ceil)
+            last = c.end();
+        else if (p.above > right)
+            last = probe_bound_from<false>(c, last, p, gallop);
+        else
+            last = bound_from<true>(c, last, saturating_add(*p.ceil, distance_within<K>(right, p.above)), gallop);
+        if (last > first)
+            counts[i] = size_t(last - first);
+    }
+}
+
+/// Calls f with the numbers in values, which may be a NumPy array or any sequence of numbers, as an array of keys of
+/// type K if they already are, or otherwise as an array of int64_t, uint64_t or double according to their kind, so that
+/// they are not cast to K.
+template <typename K, typename F> auto with_numbers(py::handle values, F f) {
+    auto array = py::array::ensure(values);
+    if (!array)
+        throw py::type_error("the values must be numbers");
+    if (py::isinstance<array_of<K>>(array))
+        return f(array.cast<array_of<K>>());
+    if (!py::isinstance<py::array>(values) && (array.dtype().kind() == 'f' || array.dtype().kind() == 'O')) {
+        // NumPy turns a sequence with ints beyond the range of int64 into floats or objects, while uint64 may hold them
+        auto ints = true;
+        for (auto it = py::iter(values); ints && it != py::iterator::sentinel(); ++it)
+            ints = py::isinstance<py::int_>(*it);
+        if (ints)
+            if (auto exact = array_of<uint64_t>::ensure(values))
+                return f(exact);
+    }
+    switch (array.dtype().kind()) {
+    case 'b':
+    case 'i':
+        return f(array_of<int64_t>::ensure(array));
+    case 'u':
+        return f(array_of<uint64_t>::ensure(array));
+    case 'f':
+        return f(array_of<double>::ensure(array));
+    default:
+        throw py::type_error("the values must be numbers");
+    }
+}
+
+/// Calls f with the number of values and with a function that returns the i-th of them probed among the keys of type K,
+/// so that the numbers in values are compared exactly with the keys rather than cast to K.
+template <typename K, typename F> auto with_probes(py::handle values, F f) {
+    return with_numbers<K>(values, [&](auto typed) {
+        auto x = typed.data();
+        return f(size_t(typed.size()), [x](size_t i) { return key_probe<K>(x[i]); });
+    });
+}
+
+/// Converts the numbers in values to keys of type K, without casting them to K first. The flag of a value in valid is
+/// cleared if no key equals the value, in which case its key is arbitrary.
+template <typename K> array_of<K> exact_keys(py::handle values, std::vector<uint8_t> &valid) {
+    return with_probes<K>(values, [&](size_t n, auto probe_at) {
+        array_of<K> keys(n);
+        auto k = keys.mutable_data();
+        valid.assign(n, 1);
+        without_gil(n, [&] {
+            for (size_t i = 0; i < n; ++i) {
+                auto probe = probe_at(i);
+                valid[i] = probe.exact();
+                k[i] = probe.exact() ? *probe.floor : K();
+            }
+        });
+        return keys;
+    });
+}
+
+/// Returns the position in c of the first element larger than each of the numbers in values if upper, or of the first
+/// element not smaller than it otherwise, using the given number of threads.
+template <typename K, typename C>
+std::vector<size_t> bound_positions(const C &c, py::handle values, bool upper, int threads = 1) {
+    return with_probes<K>(values, [&](size_t n, auto probe_at) {
+        std::vector<size_t> positions(n);
+        without_gil(n, [&] {
+            parallel_for(n, threads, [&](size_t i) {
+                auto probe = probe_at(i);
+                auto it = upper ? probe_bound<true>(c, probe) : probe_bound<false>(c, probe);
+                positions[i] = size_t(it - c.begin());
+            });
+        });
+        return positions;
+    });
+}
+
+/// Writes whether each of the n values in x is an element of c, using the given number of threads. If sort is true, the
+/// values are probed in sorted order, so that each search starts from the previous one and accesses nearby memory.
+template <typename C, typename K> void isin(const C &c, const K *x, size_t n, bool sort, int threads, bool *out) {
+    if (!sort) {
+        parallel_for(n, threads, [&](size_t i) { out[i] = x[i] == x[i] && c.contains(x[i]); });
+        return;
+    }
 
-        .def("__contains__", &PGM::contains)
+    std::vector<size_t> order;
+    order.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = false;
+        if (x[i] == x[i])
+            order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return x[a] < x[b]; });
+
+    auto chunks = size_t(std::max(threads, 1));
+    parallel_for(chunks, threads, [&](size_t t) {
+        auto it = c.begin();
+        for (auto j = order.size() * t / chunks; j < order.size() * (t + 1) / chunks; ++j) {
+            auto value = x[order[j]];
+            it = bound_from<false>(c, it, value, 2 * c.get_epsilon());
+            out[order[j]] = it != c.end() && *it == value;
+        }
+    });
+}
+
+/// Returns the mean of the elements of c at the positions in [i, j), or NaN if the range is empty.
+template <typename C> double mean(const C &c, size_t i, size_t j) {
+    return i < j ? double(c.sum(i, j) / (long double) (j - i)) : std::numeric_limits<double>::quiet_NaN();
+}
+
+/// Converts a sum of keys to a Python number, going through its decimal digits if it is too large for pybind11.
+template <typename T> py::object sum_to_python(T x) {
+    if constexpr (std::is_same_v<T, __int128>) {
+        if (x >= std::numeric_limits<int64_t>::min() && x <= std::numeric_limits<int64_t>::max())
+            return py::int_(int64_t(x));
+        auto negative = x < 0;
+        auto u = negative ? -(unsigned __int128) x : (unsigned __int128) x;
+        std::string digits;
+        for (; u > 0; u /= 10)
+            digits.push_back(char('0' + int(u % 10)));
+        if (negative)
+            digits.push_back('-');
+        return py::int_(py::str(std::string(digits.rbegin(), digits.rend())));
+    } else
+        return py::cast(x);
+}
+
+/// Declares the read-only queries shared by the container class C and its views.
+template <typename K, typename Storage, typename C, typename Class> void declare_queries(Class &cls) {
+    using PGM = PGMWrapper<K, Storage>;
+    using P = ProbeOf<K>;
+
+    // sequence protocol
+    cls.def("__len__", &C::size)
+
+        .def("__contains__", [](const C &p, P x) { return in_key_range<K>(x) && p.contains(K(x)); })
 
         .def(
             "slice",
-            [](const PGM &p, py::slice slice) -> PGM * {
+            [](const C &p, py::slice slice) -> PGM * {
                 size_t start, stop, step, length;
                 if (!slice.compute(p.size(), &start, &stop, &step, &length))
                     throw py::error_already_set();
@@ -359,13 +2241,13 @@ template <typename K> void declare_class(py::module &m, const std::string &name)
                     out.push_back(x);
                 }
 
-                return new PGM(std::move(out), duplicates, p.get_epsilon());
+                return new PGM(std::move(out), duplicates, p.get_epsilon(), p.is_quantized());
             },
             "slice"_a.noconvert())
 
         .def(
             "__getitem__",
-            [](const PGM &p, ssize_t i) {
+            [](const C &p, ssize_t i) {
                 if (i < 0)
                     i += p.size();
                 if (i < 0 || (size_t) i >= p.size())
@@ -375,67 +2257,355 @@ template <typename K> void declare_class(py::module &m, const std::string &name)
             "i"_a.noconvert())
 
         .def(
-            "__iter__", [](const PGM &p) { return py::make_iterator(p.begin(), p.end()); }, py::keep_alive<0, 1>())
+            "__iter__", [](const C &p) { return py::make_iterator(p.begin(), p.end()); }, py::keep_alive<0, 1>())
 
         .def(
             "__reversed__",
-            [](const PGM &p) {
+            [](const C &p) {
                 return py::make_iterator(std::make_reverse_iterator(p.end()), std::make_reverse_iterator(p.begin()));
             },
             py::keep_alive<0, 1>())
 
+        .def_static("format", [] { return py::format_descriptor<K>::format(); })
+
+        .def("decode",
+             [](const C &p, py::buffer out, size_t i) {
+                 auto info = out.request(true);
+                 if (info.ndim != 1 || info.itemsize != ssize_t(sizeof(K)) || info.strides[0] != ssize_t(sizeof(K)))
+                     throw std::invalid_argument("the output must be a contiguous array of " +
+                                                 py::format_descriptor<K>::format());
+                 auto n = size_t(info.shape[0]);
+                 if (i > p.size() || n > p.size() - i)
+                     throw py::index_error();
+                 auto first = p.begin() + i;
+                 without_gil(n, [&] { std::copy(first, first + n, static_cast<K *>(info.ptr)); });
+             })
+
         // query operations
-        .def("bisect_left", [](const PGM &p, K x) { return std::distance(p.begin(), p.lower_bound(x)); })
+        .def("bisect_left", [](const C &p, P x) { return std::distance(p.begin(), probe_bound<false, K>(p, x)); })
 
-        .def("bisect_right", [](const PGM &p, K x) { return std::distance(p.begin(), p.upper_bound(x)); })
+        .def("bisect_right", [](const C &p, P x) { return std::distance(p.begin(), probe_bound<true, K>(p, x)); })
 
         .def("find_lt",
-             [](const PGM &p, K x) {
-                 auto it = p.lower_bound(x);
+             [](const C &p, P x) {
+                 auto it = probe_bound<false, K>(p, x);
                  if (it <= p.begin())
                      return py::object(py::cast(nullptr));
                  return py::cast(*(it - 1));
              })
 
         .def("find_le",
-             [](const PGM &p, K x) {
-                 auto it = p.upper_bound(x);
+             [](const C &p, P x) {
+                 auto it = probe_bound<true, K>(p, x);
                  if (it <= p.begin())
                      return py::object(py::cast(nullptr));
                  return py::cast(*(it - 1));
              })
 
         .def("find_gt",
-             [](const PGM &p, K x) -> py::object {
-                 auto it = p.upper_bound(x);
+             [](const C &p, P x) -> py::object {
+                 auto it = probe_bound<true, K>(p, x);
                  if (it >= p.end())
                      return py::object(py::cast(nullptr));
                  return py::cast(*it);
              })
 
         .def("find_ge",
-             [](const PGM &p, K x) -> py::object {
-                 auto it = p.lower_bound(x);
+             [](const C &p, P x) -> py::object {
+                 auto it = probe_bound<false, K>(p, x);
                  if (it >= p.end())
                      return py::object(py::cast(nullptr));
                  return py::cast(*it);
              })
 
-        .def("rank", [](const PGM &p, K x) { return std::distance(p.begin(), p.upper_bound(x)); })
+        .def("rank", [](const C &p, P x) { return std::distance(p.begin(), probe_bound<true, K>(p, x)); })
+
+        .def("approx_rank",
+             [](const C &p, P x) {
+                 auto range = approx_rank(p, key_probe<K>(x));
+                 return std::make_tuple(range.pos, range.lo, range.hi);
+             })
+
+        .def("approx_ranks",
+             [](const C &p, py::handle xs) {
+                 return with_probes<K>(xs, [&](size_t n, auto probe_at) {
+                     array_of<size_t> pos(n), lo(n), hi(n);
+                     auto out_pos = pos.mutable_data(), out_lo = lo.mutable_data(), out_hi = hi.mutable_data();
+                     without_gil(n, [&] {
+                         for (size_t i = 0; i < n; ++i) {
+                             auto range = approx_rank(p, probe_at(i));
+                             out_pos[i] = range.pos;
+                             out_lo[i] = range.lo;
+                             out_hi[i] = range.hi;
+                         }
+                     });
+                     return std::make_tuple(pos, lo, hi);
+                 });
+             })
+
+        .def("quantile",
+             [](const C &p, double q) {
+                 check_quantiles(p, &q, 1);
+                 return quantile(p, q);
+             })
+
+        .def("quantiles",
+             [](const C &p, array_of<double> qs) {
+                 auto n = size_t(qs.size());
+                 auto q = qs.data();
+                 check_quantiles(p, q, n);
+                 array_of<double> out(n);
+                 auto results = out.mutable_data();
+                 without_gil(n, [&] {
+                     for (size_t i = 0; i < n; ++i)
+                         results[i] = quantile(p, q[i]);
+                 });
+                 return out;
+             })
+
+        .def("cdf",
+             [](const C &p, py::handle xs, bool approximate) {
+                 if (p.size() == 0)
+                     throw std::invalid_argument("cdf of an empty container");
+                 return with_probes<K>(xs, [&](size_t n, auto probe_at) {
+                     array_of<double> out(n);
+                     auto results = out.mutable_data();
+                     without_gil(n, [&] {
+                         for (size_t i = 0; i < n; ++i)
+                             results[i] = cdf(p, probe_at(i), approximate);
+                     });
+                     return out;
+                 });
+             })
+
+        .def("window_counts",
+             [](const C &p, py::handle xs, DistanceOf<K> left, std::optional<DistanceOf<K>> right) {
+                 return with_probes<K>(xs, [&](size_t n, auto probe_at) {
+                     array_of<size_t> out(n);
+                     auto counts = out.mutable_data();
+                     without_gil(n, [&] { window_counts<K>(p, n, probe_at, left, right.value_or(left), counts); });
+                     return out;
+                 });
+             })
+
+        .def("has_row_ids", &C::has_row_ids)
+
+        .def("row_ids",
+             [](const C &p, size_t i, size_t j) {
+                 if (!p.has_row_ids())
+                     throw std::invalid_argument("the container was not built from a column");
+                 if (i > j || j > p.size())
+                     throw py::index_error();
+                 array_of<size_t> out(j - i);
+                 auto ids = out.mutable_data();
+                 for (size_t k = i; k < j; ++k)
+                     ids[k - i] = p.row_id(k);
+                 return out;
+             })
+
+        .def("isin",
+             [](const C &p, py::handle values, bool sort, int threads) {
+                 std::vector<uint8_t> valid;
+                 auto keys = exact_keys<K>(values, valid);
+                 auto n = size_t(keys.size());
+                 auto x = keys.data();
+                 array_of<bool> out(n);
+                 auto mask = out.mutable_data();
+                 without_gil(n, [&] {
+                     isin(p, x, n, sort, threads, mask);
+                     for (size_t i = 0; i < n; ++i)
+                         mask[i] = mask[i] && valid[i];
+                 });
+                 return out;
+             })
+
+        .def("digitize",
+             [](const C &p, py::handle values, bool right, int threads) {
+                 return with_probes<K>(values, [&](size_t n, auto probe_at) {
+                     array_of<size_t> out(n);
+                     auto bins = out.mutable_data();
+                     without_gil(n, [&] {
+                         parallel_for(n, threads, [&](size_t i) {
+                             auto probe = probe_at(i);
+                             auto it = right ? probe_bound<false>(p, probe) : probe_bound<true>(p, probe);
+                             bins[i] = it - p.begin();
+                         });
+                     });
+                     return out;
+                 });
+             })
+
+        .def("histogram",
+             [](const C &p, py::handle values, int threads) {
+                 return with_probes<K>(values, [&](size_t n, auto probe_at) {
+                     array_of<size_t> out(p.size() < 2 ? 0 : p.size() - 1);
+                     auto counts = out.mutable_data();
+                     std::fill_n(counts, out.size(), 0);
+                     if (out.size() == 0)
+                         return out;
+                     auto last = p[p.size() - 1];
+                     without_gil(n, [&] {
+                         parallel_for(n, threads, [&](size_t i) {
+                             // the last bin is closed, so it also counts the values equal to the last edge
+                             auto probe = probe_at(i);
+                             auto bin = size_t(probe_bound<true>(p, probe) - p.begin());
+                             if (bin == p.size() && probe.exact() && *probe.floor == last)
+                                 bin = p.size() - 1;
+                             if (bin == 0 || bin == p.size())
+                                 return;
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+                             ++counts[bin - 1];
+                         });
+                     });
+                     return out;
+                 });
+             })
+
+        .def("nearest",
+             [](const C &p, P x, size_t k) {
+                 k = std::min(k, p.size());
+                 array_of<size_t> positions(k);
+                 array_of<K> keys(k);
+                 auto out_positions = positions.mutable_data();
+                 auto out_keys = keys.mutable_data();
+                 nearest(p, key_probe<K>(x), k, out_positions);
+                 for (size_t i = 0; i < k; ++i)
+                     out_keys[i] = p[out_positions[i]];
+                 return std::make_tuple(positions, keys);
+             })
+
+        .def("nearest_many",
+             [](const C &p, py::handle xs, size_t k) {
+                 k = std::min(k, p.size());
+                 return with_probes<K>(xs, [&](size_t n, auto probe_at) {
+                     array_of<size_t> positions(std::vector<ssize_t>{ssize_t(n), ssize_t(k)});
+                     array_of<K> keys(std::vector<ssize_t>{ssize_t(n), ssize_t(k)});
+                     auto out_positions = positions.mutable_data();
+                     auto out_keys = keys.mutable_data();
+                     without_gil(n * k, [&] {
+                         for (size_t i = 0; i < n; ++i)
+                             nearest(p, probe_at(i), k, out_positions + i * k);
+                         for (size_t i = 0; i < n * k; ++i)
+                             out_keys[i] = p[out_positions[i]];
+                     });
+                     return std::make_tuple(positions, keys);
+                 });
+             })
+
+        .def("asof",
+             [](const C &p, py::handle values, const std::string &direction,
+                std::optional<DistanceOf<K>> tolerance) {
+                 static const std::unordered_map<std::string, AsofDirection> directions = {
+                     {"backward", AsofDirection::backward},
+                     {"forward", AsofDirection::forward},
+                     {"nearest", AsofDirection::nearest}};
+                 auto it = directions.find(direction);
+                 if (it == directions.end())
+                     throw std::invalid_argument("direction must be 'backward', 'forward' or 'nearest'");
+                 return with_probes<K>(values, [&](size_t n, auto probe_at) {
+                     array_of<int64_t> positions(n);
+                     array_of<K> keys(n);
+                     auto out_positions = positions.mutable_data();
+                     auto out_keys = keys.mutable_data();
+                     without_gil(n, [&] { asof(p, n, probe_at, it->second, tolerance, out_positions, out_keys); });
+                     return std::make_tuple(positions, keys);
+                 });
+             })
+
+        .def("count_range", &count_range<K, C, P>)
+
+        .def("count_ranges",
+             [](const C &p, py::handle starts, py::handle ends, std::pair<bool, bool> inclusive) {
+                 auto first = bound_positions<K>(p, starts, !inclusive.first);
+                 auto last = bound_positions<K>(p, ends, inclusive.second);
+                 if (first.size() != last.size())
+                     throw std::invalid_argument("starts and ends must have the same length");
+                 auto n = first.size();
+                 array_of<size_t> out(n);
+                 auto counts = out.mutable_data();
+                 for (size_t i = 0; i < n; ++i)
+                     counts[i] = std::max(first[i], last[i]) - first[i];
+                 return out;
+             })
+
+        .def("range_sum",
+             [](const C &p, P a, P b, std::pair<bool, bool> inclusive) {
+                 auto [i, j] = range_positions<K>(p, a, b, inclusive);
+                 return sum_to_python(p.sum(i, j));
+             })
+
+        .def("range_mean",
+             [](const C &p, P a, P b, std::pair<bool, bool> inclusive) {
+                 auto [i, j] = range_positions<K>(p, a, b, inclusive);
+                 return mean(p, i, j);
+             })
+
+        .def("range_sums",
+             [](const C &p, py::handle starts, py::handle ends, std::pair<bool, bool> inclusive, bool means) {
+                 auto first = bound_positions<K>(p, starts, !inclusive.first);
+                 auto last = bound_positions<K>(p, ends, inclusive.second);
+                 if (first.size() != last.size())
+                     throw std::invalid_argument("starts and ends must have the same length");
+                 auto n = first.size();
+                 p.prefix_sums();
+                 if (means) {
+                     array_of<double> out(n);
+                     auto results = out.mutable_data();
+                     without_gil(n, [&] {
+                         for (size_t k = 0; k < n; ++k)
+                             results[k] = mean(p, first[k], std::max(first[k], last[k]));
+                     });
+                     return py::object(out);
+                 }
+                 if constexpr (std::is_floating_point_v<K>) {
+                     array_of<double> out(n);
+                     auto results = out.mutable_data();
+                     without_gil(n, [&] {
+                         for (size_t k = 0; k < n; ++k)
+                             results[k] = double(p.sum(first[k], std::max(first[k], last[k])));
+                     });
+                     return py::object(out);
+                 } else {
+                     // the sums of 64-bit keys may not fit in 64 bits, in which case they are returned as Python ints
+                     using Out = std::conditional_t<std::is_signed_v<K> || sizeof(K) < 8, int64_t, uint64_t>;
+                     std::vector<SumOf<K>> sums(n);
+                     auto fits = true;
+                     without_gil(n, [&] {
+                         for (size_t k = 0; k < n; ++k) {
+                             sums[k] = p.sum(first[k], std::max(first[k], last[k]));
+                             fits &= sums[k] >= std::numeric_limits<Out>::min() &&
+                                     sums[k] <= std::numeric_limits<Out>::max();
+                         }
+                     });
+                     if (!fits) {
+                         py::list out;
+                         for (auto sum : sums)
+                             out.append(sum_to_python(sum));
+                         return py::module_::import("numpy").attr("array")(out, py::arg("dtype") = "object");
+                     }
+                     array_of<Out> out(n);
+                     std::copy(sums.begin(), sums.end(), out.mutable_data());
+                     return py::object(out);
+                 }
+             })
 
         .def("count",
-             [](const PGM &p, K x) -> size_t {
-                 auto lb = p.lower_bound(x);
-                 if (lb >= p.end() || *lb != x)
+             [](const C &p, P x) -> size_t {
+                 if (!in_key_range<K>(x))
+                     return 0;
+                 auto lb = p.lower_bound(K(x));
+                 if (lb >= p.end() || *lb != K(x))
                      return 0;
-                 return std::distance(lb, p.upper_bound(x));
+                 return std::distance(lb, p.upper_bound(K(x)));
              })
 
         .def(
             "range",
-            [](const PGM &p, K a, K b, std::pair<bool, bool> inclusive, bool reverse) {
-                auto l_it = inclusive.first ? p.lower_bound(a) : p.upper_bound(a);
-                auto r_it = inclusive.second ? p.upper_bound(b) : p.lower_bound(b);
+            [](const C &p, P a, P b, std::pair<bool, bool> inclusive, bool reverse) {
+                auto l_it = inclusive.first ? probe_bound<false, K>(p, a) : probe_bound<true, K>(p, a);
+                auto r_it = inclusive.second ? probe_bound<true, K>(p, b) : probe_bound<false, K>(p, b);
                 if (reverse)
                     return py::make_iterator(std::make_reverse_iterator(r_it), std::make_reverse_iterator(l_it));
                 return py::make_iterator(l_it, r_it);
@@ -444,17 +2614,261 @@ template <typename K> void declare_class(py::module &m, const std::string &name)
 
         // list-like operations
         .def("index",
-             [](const PGM &p, K x, std::optional<ssize_t> start, std::optional<ssize_t> stop) -> py::object {
-                 auto it = p.lower_bound(x);
+             [](const C &p, P x, std::optional<ssize_t> start, std::optional<ssize_t> stop) -> py::object {
+                 auto it = probe_bound<false, K>(p, x);
                  auto index = (size_t) std::distance(p.begin(), it);
 
                  size_t left, right, step, length;
                  auto slice = py::slice(start.value_or(0), stop.value_or(p.size()), 1);
                  slice.compute(p.size(), &left, &right, &step, &length);
 
-                 if (it >= p.end() || *it != x || index < left || index > right)
+                 if (!in_key_range<K>(x) || it >= p.end() || *it != K(x) || index < left || index > right)
                      throw py::value_error(std::to_string(x) + " is not in PGMIndex");
                  return py::cast(index);
+             });
+}
+
+/// Copies the first keys, the slopes and the intercepts of some segments into NumPy arrays.
+template <typename K>
+auto segments_to_arrays(const std::tuple<std::vector<K>, std::vector<double>, std::vector<size_t>> &segments) {
+    auto to_array = [](const auto &v) {
+        array_of<typename std::decay_t<decltype(v)>::value_type> out(v.size());
+        std::copy(v.begin(), v.end(), out.mutable_data());
+        return out;
+    };
+    return std::make_tuple(to_array(std::get<0>(segments)), to_array(std::get<1>(segments)),
+                           to_array(std::get<2>(segments)));
+}
+
+template <typename K, typename Storage = std::vector<K>> void declare_class(py::module &m, const std::string &name) {
+    using PGM = PGMWrapper<K, Storage>;
+    using View = PGMView<K, Storage>;
+    constexpr bool contiguous = std::is_same_v<Storage, std::vector<K>>;
+    auto cls = contiguous ? py::class_<PGM>(m, name.c_str(), py::buffer_protocol()) : py::class_<PGM>(m, name.c_str());
+
+    cls.def(py::init<>())
+        .def(py::init<const PGM &, bool, size_t>())
+        .def(py::init<py::iterator, size_t, bool, size_t, bool>())
+
+        .def_static("from_column",
+                    [](array_of<K> column, bool drop_duplicates, size_t epsilon, bool quantize, int threads) {
+                        return new PGM(column.data(), column.size(), drop_duplicates, epsilon, quantize, threads);
+                    })
+
+        .def_static("from_array",
+                    [](array_of<K> values, bool drop_duplicates, size_t epsilon, bool quantize) {
+                        std::vector<K> keys(values.data(), values.data() + values.size());
+                        without_gil(keys.size(), [&] {
+                            if (!std::is_sorted(keys.begin(), keys.end()))
+                                std::sort(keys.begin(), keys.end());
+                            if (drop_duplicates)
+                                keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+                        });
+                        return new PGM(std::move(keys), !drop_duplicates, epsilon, quantize);
+                    })
+
+        .def(
+            "view",
+            [](const PGM &p, size_t i, size_t j) {
+                if (i > j || j > p.size())
+                    throw py::index_error();
+                return View(p, i, j);
+            },
+            py::keep_alive<0, 1>())
+
+        // multiset operations
+        .def("merge", &PGM::template merge<const PGM &>)
+        .def("merge", &PGM::template merge<py::iterator>)
+
+        .def("drop_duplicates", [](const PGM &p) { return new PGM(p, true, p.get_epsilon()); })
+
+        // set operations
+        .def("difference", &PGM::template set_difference<const PGM &>)
+        .def("difference", &PGM::template set_difference<py::iterator>)
+
+        .def("symmetric_difference", &PGM::template set_symmetric_difference<const PGM &>)
+        .def("symmetric_difference", &PGM::template set_symmetric_difference<py::iterator>)
+
+        .def("union", &PGM::template set_union<const PGM &>)
+        .def("union", &PGM::template set_union<py::iterator>)
+
+        .def("intersection", &PGM::template set_intersection<const PGM &>)
+        .def("intersection", &PGM::template set_intersection<py::iterator>)
+
+        .def("subset", py::overload_cast<const PGM &, size_t, bool>(&PGM::template subset<false>, py::const_))
+        .def("subset", py::overload_cast<py::iterator, size_t, bool>(&PGM::template subset<false>, py::const_))
+
+        .def("superset", py::overload_cast<const PGM &, size_t, bool>(&PGM::template subset<true>, py::const_))
+        .def("superset", py::overload_cast<py::iterator, size_t, bool>(&PGM::template subset<true>, py::const_))
+
+        .def("equal_to", py::overload_cast<const PGM &, size_t>(&PGM::equal_to, py::const_))
+        .def("equal_to", py::overload_cast<py::iterator, size_t>(&PGM::equal_to, py::const_))
+
+        .def("not_equal_to", py::overload_cast<const PGM &, size_t>(&PGM::not_equal_to, py::const_))
+        .def("not_equal_to", py::overload_cast<py::iterator, size_t>(&PGM::not_equal_to, py::const_))
+
+        // other methods
+        .def("stats", &PGM::stats)
+
+        .def("segments", [](const PGM &p) { return segments_to_arrays(p.leaf_segments()); })
+
+        .def("has_duplicates", &PGM::has_duplicates);
+
+    declare_queries<K, Storage, PGM>(cls);
+
+    auto view_name = "PGMView" + name.substr(std::string("PGMIndex").size());
+    auto view_cls = contiguous ? py::class_<View>(m, view_name.c_str(), py::buffer_protocol())
+                               : py::class_<View>(m, view_name.c_str());
+
+    view_cls
+        .def(
+            "view",
+            [](const View &v, size_t i, size_t j) {
+                if (i > j || j > v.size())
+                    throw py::index_error();
+                return v.view(i, j);
+            },
+            py::keep_alive<0, 1>())
+
+        .def("stats", [](const View &v) { return v.parent().stats(); })
+
+        .def("segments", [](const View &v) { return segments_to_arrays(v.parent().leaf_segments()); })
+
+        .def("has_duplicates", [](const View &v) { return v.parent().has_duplicates(); });
+
+    declare_queries<K, Storage, View>(view_cls);
+
+    if constexpr (contiguous) {
+        cls.def_buffer([](const PGM &p) { return p.buffer_info(0, p.size()); });
+        view_cls.def_buffer(&View::buffer_info);
+    }
+}
+
+/// Declares a container of keys indexed via a projection, which supports the operations of the sorted containers that
+/// do not need arithmetic on the keys, and returns it so that the queries specific to the keys can be added.
+template <typename Keys> auto declare_projected_class(py::module &m, const std::string &name) {
+    using PGM = ProjectedWrapper<Keys>;
+    auto key = [](py::handle h) { return Keys::from_python(h); };
+    auto cls = py::class_<PGM>(m, name.c_str());
+
+    cls.def(py::init<>())
+        .def(py::init<const PGM &, bool, size_t>())
+        .def(py::init<py::iterator, size_t, bool, size_t, bool>())
+
+        // sequence protocol
+        .def("__len__", &PGM::size)
+
+        .def("__contains__", [=](const PGM &p, py::handle x) { return p.contains(key(x)); })
+
+        .def(
+            "slice",
+            [](const PGM &p, py::slice slice) {
+                size_t start, stop, step, length;
+                if (!slice.compute(p.size(), &start, &stop, &step, &length))
+                    throw py::error_already_set();
+
+                bool duplicates = false;
+                std::vector<typename Keys::value_type> out;
+                out.reserve(length);
+                for (size_t i = 0; i < length; ++i, start += step) {
+                    if (i > 0 && p.key(start) == out.back())
+                        duplicates = true;
+                    out.push_back(p.key(start));
+                }
+                return new PGM(out, duplicates, p.get_epsilon());
+            },
+            "slice"_a.noconvert())
+
+        .def(
+            "__getitem__",
+            [](const PGM &p, ssize_t i) {
+                if (i < 0)
+                    i += p.size();
+                if (i < 0 || (size_t) i >= p.size())
+                    throw py::index_error();
+                return p[i];
+            },
+            "i"_a.noconvert())
+
+        .def(
+            "__iter__", [](const PGM &p) { return py::make_iterator(p.begin(), p.end()); }, py::keep_alive<0, 1>())
+
+        .def(
+            "__reversed__",
+            [](const PGM &p) {
+                return py::make_iterator(std::make_reverse_iterator(p.end()), std::make_reverse_iterator(p.begin()));
+            },
+            py::keep_alive<0, 1>())
+
+        // query operations
+        .def("bisect_left", [=](const PGM &p, py::handle x) { return p.lower_bound(key(x)); })
+
+        .def("bisect_right", [=](const PGM &p, py::handle x) { return p.upper_bound(key(x)); })
+
+        .def("find_lt",
+             [=](const PGM &p, py::handle x) -> py::object {
+                 auto i = p.lower_bound(key(x));
+                 if (i == 0)
+                     return py::object(py::cast(nullptr));
+                 return p[i - 1];
+             })
+
+        .def("find_le",
+             [=](const PGM &p, py::handle x) -> py::object {
+                 auto i = p.upper_bound(key(x));
+                 if (i == 0)
+                     return py::object(py::cast(nullptr));
+                 return p[i - 1];
+             })
+
+        .def("find_gt",
+             [=](const PGM &p, py::handle x) -> py::object {
+                 auto i = p.upper_bound(key(x));
+                 if (i == p.size())
+                     return py::object(py::cast(nullptr));
+                 return p[i];
+             })
+
+        .def("find_ge",
+             [=](const PGM &p, py::handle x) -> py::object {
+                 auto i = p.lower_bound(key(x));
+                 if (i == p.size())
+                     return py::object(py::cast(nullptr));
+                 return p[i];
+             })
+
+        .def("rank", [=](const PGM &p, py::handle x) { return p.upper_bound(key(x)); })
+
+        .def("count",
+             [=](const PGM &p, py::handle x) {
+                 auto k = key(x);
+                 return p.upper_bound(k) - p.lower_bound(k);
+             })
+
+        .def(
+            "range",
+            [=](const PGM &p, py::handle a, py::handle b, std::pair<bool, bool> inclusive, bool reverse) {
+                auto i = inclusive.first ? p.lower_bound(key(a)) : p.upper_bound(key(a));
+                auto j = std::max(i, inclusive.second ? p.upper_bound(key(b)) : p.lower_bound(key(b)));
+                auto l_it = p.begin() + i, r_it = p.begin() + j;
+                if (reverse)
+                    return py::make_iterator(std::make_reverse_iterator(r_it), std::make_reverse_iterator(l_it));
+                return py::make_iterator(l_it, r_it);
+            },
+            py::keep_alive<0, 1>())
+
+        // list-like operations
+        .def("index",
+             [=](const PGM &p, py::handle x, std::optional<ssize_t> start, std::optional<ssize_t> stop) {
+                 auto index = p.lower_bound(key(x));
+
+                 size_t left, right, step, length;
+                 auto slice = py::slice(start.value_or(0), stop.value_or(p.size()), 1);
+                 slice.compute(p.size(), &left, &right, &step, &length);
+
+                 if (!p.contains(key(x)) || index < left || index > right)
+                     throw py::value_error(std::string(py::repr(x)) + " is not in PGMIndex");
+                 return index;
              })
 
         // multiset operations
@@ -492,13 +2906,113 @@ template <typename K> void declare_class(py::module &m, const std::string &name)
         .def("stats", &PGM::stats)
 
         .def("has_duplicates", &PGM::has_duplicates);
+
+    return cls;
+}
+
+/// Byte strings to probe, viewed in place in a NumPy array of fixed-length bytes or copied from any other sequence.
+class ByteProbes {
+    py::object array;
+    std::vector<std::string> owned;
+    std::vector<std::string_view> items;
+
+  public:
+    /// Reads the items of a NumPy array of fixed-length bytes without the null bytes that pad them, as NumPy does, and
+    /// the items of any other sequence as bytes of their own length, so that keys ending with null bytes are found.
+    explicit ByteProbes(py::handle values) {
+        if (py::isinstance<py::array>(values) && values.cast<py::array>().dtype().kind() == 'S') {
+            array = py::reinterpret_borrow<py::object>(values);
+            auto info = array.cast<py::buffer>().request();
+            if (info.ndim != 1)
+                throw std::invalid_argument("the values must be a one-dimensional array of bytes");
+            items.reserve(info.shape[0]);
+            for (ssize_t i = 0; i < info.shape[0]; ++i) {
+                auto first = static_cast<const char *>(info.ptr) + i * info.strides[0];
+                auto length = size_t(info.itemsize);
+                while (length > 0 && first[length - 1] == 0)
+                    --length;
+                items.emplace_back(first, length);
+            }
+            return;
+        }
+        for (auto it = py::iter(values); it != py::iterator::sentinel(); ++it)
+            owned.push_back(ByteKeys::from_python(*it));
+        items.assign(owned.begin(), owned.end());
+    }
+
+    size_t size() const { return items.size(); }
+
+    std::string_view operator[](size_t i) const { return items[i]; }
+};
+
+/// Declares the queries of a container of byte strings that take a sequence of bytes.
+template <typename Class> void declare_byte_queries(Class &cls) {
+    using PGM = typename Class::type;
+
+    cls.def("digitize",
+            [](const PGM &p, py::handle values, bool right, int threads) {
+                ByteProbes probes(values);
+                auto n = probes.size();
+                array_of<size_t> out(n);
+                auto bins = out.mutable_data();
+                without_gil(n, [&] {
+                    parallel_for(n, threads, [&](size_t i) {
+                        bins[i] = right ? p.lower_bound(probes[i]) : p.upper_bound(probes[i]);
+                    });
+                });
+                return out;
+            })
+
+        .def("isin", [](const PGM &p, py::handle values, bool sort, int threads) {
+            ByteProbes probes(values);
+            auto n = probes.size();
+            array_of<bool> out(n);
+            auto found = out.mutable_data();
+            without_gil(n, [&] {
+                std::vector<size_t> order(n);
+                std::iota(order.begin(), order.end(), 0);
+                if (sort)
+                    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return probes[a] < probes[b]; });
+                parallel_for(n, threads, [&](size_t i) { found[order[i]] = p.contains(probes[order[i]]); });
+            });
+            return out;
+        });
 }
 
 PYBIND11_MODULE(_pygm, m) {
+    declare_class<uint8_t>(m, "PGMIndexUInt8");
+    declare_class<int8_t>(m, "PGMIndexInt8");
+    declare_class<uint16_t>(m, "PGMIndexUInt16");
+    declare_class<int16_t>(m, "PGMIndexInt16");
     declare_class<uint32_t>(m, "PGMIndexUInt32");
     declare_class<int32_t>(m, "PGMIndexInt32");
     declare_class<int64_t>(m, "PGMIndexInt64");
     declare_class<uint64_t>(m, "PGMIndexUInt64");
     declare_class<float>(m, "PGMIndexFloat");
     declare_class<double>(m, "PGMIndexDouble");
+
+    declare_class<uint32_t, EliasFano<uint32_t>>(m, "PGMIndexEliasFanoUInt32");
+    declare_class<int32_t, EliasFano<int32_t>>(m, "PGMIndexEliasFanoInt32");
+    declare_class<int64_t, EliasFano<int64_t>>(m, "PGMIndexEliasFanoInt64");
+    declare_class<uint64_t, EliasFano<uint64_t>>(m, "PGMIndexEliasFanoUInt64");
+
+    declare_class<uint32_t, ResidualStorage<uint32_t>>(m, "PGMIndexResidualUInt32");
+    declare_class<int32_t, ResidualStorage<int32_t>>(m, "PGMIndexResidualInt32");
+    declare_class<int64_t, ResidualStorage<int64_t>>(m, "PGMIndexResidualInt64");
+    declare_class<uint64_t, ResidualStorage<uint64_t>>(m, "PGMIndexResidualUInt64");
+
+    declare_class<uint32_t, RunLengthStorage<uint32_t>>(m, "PGMIndexRunLengthUInt32");
+    declare_class<int32_t, RunLengthStorage<int32_t>>(m, "PGMIndexRunLengthInt32");
+    declare_class<int64_t, RunLengthStorage<int64_t>>(m, "PGMIndexRunLengthInt64");
+    declare_class<uint64_t, RunLengthStorage<uint64_t>>(m, "PGMIndexRunLengthUInt64");
+    declare_class<float, RunLengthStorage<float>>(m, "PGMIndexRunLengthFloat");
+    declare_class<double, RunLengthStorage<double>>(m, "PGMIndexRunLengthDouble");
+
+    declare_class<uint32_t, HybridStorage<uint32_t>>(m, "PGMIndexHybridUInt32");
+
+    declare_projected_class<WideKeys<true>>(m, "PGMIndexPair");
+    declare_projected_class<WideKeys<false>>(m, "PGMIndexUInt128");
+
+    auto bytes_cls = declare_projected_class<ByteKeys>(m, "PGMIndexBytes");
+    declare_byte_queries(bytes_cls);
 }
\ No newline at end of file
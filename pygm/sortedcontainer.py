@@ -3,71 +3,495 @@ import collections.abc
 from . import _pygm
 
 
+class _TemporalImpl:
+    """Adapter of an internal container of int64 elements that holds the
+    values of a NumPy datetime64 or timedelta64 dtype. It converts the
+    arguments of the queries to int64 and the results back to the dtype,
+    viewing whole arrays in place rather than converting each value."""
+
+    def __init__(self, impl, dtype):
+        import numpy as np
+        self._impl = impl
+        self._dtype = dtype
+        self._delta = np.dtype(dtype.str.replace('M8', 'm8'))
+
+    def __getattr__(self, name):
+        return getattr(self._impl, name)
+
+    def _wrap(self, impl):
+        return _TemporalImpl(impl, self._dtype)
+
+    def _values(self, xs, dtype=None):
+        """Return xs as an array of the kind of dtype, which defaults to the
+        dtype of the elements, keeping the unit of datetime64 and timedelta64
+        values and parsing strings and Python objects in their own unit."""
+        import numpy as np
+        dtype = dtype or self._dtype
+        xs = np.asarray(xs)
+        if xs.dtype.kind in 'USO':
+            xs = np.asarray(xs, dtype.char + '8')
+        return xs if xs.dtype.kind == dtype.kind else np.asarray(xs, dtype)
+
+    def _bounds(self, xs, dtype=None):
+        """Return the floors and the ceilings of the values xs in the unit of
+        dtype, viewed as int64, and whether each value is exact in that unit.
+        NaT is its own floor and ceiling, and is never exact."""
+        import numpy as np
+        xs = self._values(xs, dtype)
+        floors = xs.astype(dtype or self._dtype)
+        exact = floors == xs
+        floors = floors.view(np.int64)
+        return floors, floors + ~(exact | np.isnat(xs)), exact
+
+    def _key(self, x, ceil=False):
+        floor, ceiling, _ = self._bounds(x)
+        return int(ceiling if ceil else floor)
+
+    def _keys(self, xs, ceil=False):
+        floors, ceilings, _ = self._bounds(xs)
+        return ceilings if ceil else floors
+
+    def _exact_key(self, x):
+        floor, _, exact = self._bounds(x)
+        return int(floor) if exact else None
+
+    def _element(self, x):
+        import numpy as np
+        return np.int64(x).view(self._dtype)
+
+    def _elements(self, xs):
+        return xs.view(self._dtype)
+
+    @staticmethod
+    def _stored(values):
+        """Return an array of datetime64 or timedelta64 values viewed as
+        int64, rejecting NaT, which is stored as the smallest int64 and would
+        then compare equal to the NaT of the queries."""
+        import numpy as np
+        if np.isnat(values).any():
+            raise ValueError('NaT cannot be stored in a sorted container')
+        return values.view(np.int64)
+
+    def _other(self, o, stored=False):
+        import numpy as np
+        if isinstance(o, _TemporalImpl) and o._dtype == self._dtype and \
+                type(o._impl) is type(self._impl):
+            return o._impl
+        values = np.asarray(list(o), self._dtype)
+        keys = self._stored(values) if stored else values.view(np.int64)
+        return iter(keys.tolist())
+
+    def asarray(self):
+        import numpy as np
+        return np.asarray(memoryview(self._impl)).view(self._dtype)
+
+    def format(self):
+        return self._dtype.str
+
+    def decode(self, out, i):
+        import numpy as np
+        self._impl.decode(out.view(np.int64), i)
+
+    def __len__(self):
+        return len(self._impl)
+
+    def __contains__(self, x):
+        key = self._exact_key(x)
+        return key is not None and self._impl.__contains__(key)
+
+    def __getitem__(self, i):
+        return self._element(self._impl[i])
+
+    def __iter__(self):
+        return map(self._element, self._impl)
+
+    def __reversed__(self):
+        return map(self._element, reversed(self._impl))
+
+    def slice(self, s):
+        return self._wrap(self._impl.slice(s))
+
+    def view(self, i, j):
+        return self._wrap(self._impl.view(i, j))
+
+    def drop_duplicates(self):
+        return self._wrap(self._impl.drop_duplicates())
+
+    def bisect_left(self, x):
+        return self._impl.bisect_left(self._key(x, True))
+
+    def bisect_right(self, x):
+        return self._impl.bisect_right(self._key(x))
+
+    def rank(self, x):
+        return self._impl.rank(self._key(x))
+
+    def count(self, x):
+        key = self._exact_key(x)
+        return 0 if key is None else self._impl.count(key)
+
+    def index(self, x, start, stop):
+        key = self._exact_key(x)
+        if key is None:
+            raise ValueError('%s is not in PGMIndex' % (x,))
+        return self._impl.index(key, start, stop)
+
+    def approx_rank(self, x):
+        return self._impl.approx_rank(self._key(x, True))
+
+    def _find(self, method, x, ceil=False):
+        y = method(self._key(x, ceil))
+        return None if y is None else self._element(y)
+
+    def find_lt(self, x):
+        return self._find(self._impl.find_lt, x, True)
+
+    def find_le(self, x):
+        return self._find(self._impl.find_le, x)
+
+    def find_gt(self, x):
+        return self._find(self._impl.find_gt, x)
+
+    def find_ge(self, x):
+        return self._find(self._impl.find_ge, x, True)
+
+    def _range_keys(self, a, b, inclusive, convert):
+        # an inclusive lower bound of a finer unit is rounded up, an exclusive
+        # one down, and symmetrically for the upper bound
+        return convert(a, inclusive[0]), convert(b, not inclusive[1])
+
+    def range(self, a, b, inclusive, reverse):
+        a, b = self._range_keys(a, b, inclusive, self._key)
+        return map(self._element, self._impl.range(a, b, inclusive, reverse))
+
+    def count_range(self, a, b, inclusive):
+        a, b = self._range_keys(a, b, inclusive, self._key)
+        return self._impl.count_range(a, b, inclusive)
+
+    def count_ranges(self, starts, ends, inclusive):
+        starts, ends = self._range_keys(starts, ends, inclusive, self._keys)
+        return self._impl.count_ranges(starts, ends, inclusive)
+
+    def range_sum(self, a, b, inclusive):
+        a, b = self._range_keys(a, b, inclusive, self._key)
+        return self._impl.range_sum(a, b, inclusive)
+
+    def range_mean(self, a, b, inclusive):
+        a, b = self._range_keys(a, b, inclusive, self._key)
+        return self._impl.range_mean(a, b, inclusive)
+
+    def range_sums(self, starts, ends, inclusive, means):
+        starts, ends = self._range_keys(starts, ends, inclusive, self._keys)
+        return self._impl.range_sums(starts, ends, inclusive, means)
+
+    def approx_ranks(self, xs):
+        return self._impl.approx_ranks(self._keys(xs, True))
+
+    def quantile(self, q):
+        # Interpolate between the stored int64 values, as the quantile of the
+        # container is a double that cannot represent every int64
+        from fractions import Fraction
+        n = len(self._impl)
+        if n == 0:
+            raise ValueError('quantile of an empty container')
+        if not 0 <= q <= 1:
+            raise ValueError('quantiles must be in the range [0, 1]')
+        h = q * (n - 1)
+        i = min(int(h), n - 1)
+        x = self._impl[i]
+        if i + 1 < n:
+            x += round(Fraction(h - i) * (self._impl[i + 1] - x))
+        return self._element(x)
+
+    def quantiles(self, qs):
+        import numpy as np
+        qs = np.asarray(qs, np.float64).ravel()
+        if len(self._impl) == 0:
+            raise ValueError('quantile of an empty container')
+        return np.array([self.quantile(q) for q in qs.tolist()], self._dtype)
+
+    def cdf(self, xs, approximate):
+        return self._impl.cdf(self._keys(xs, approximate), approximate)
+
+    def window_counts(self, xs, left, right):
+        import numpy as np
+        xs = self._values(xs).ravel()
+        left = self._values(left, self._delta)
+        right = left if right is None else self._values(right, self._delta)
+        keys, _, exact = self._bounds(xs)
+        (left_key, _, left_exact), (right_key, _, right_exact) = \
+            self._bounds(left, self._delta), self._bounds(right, self._delta)
+        if exact.all() and left_exact and right_exact:
+            return self._impl.window_counts(keys, int(left_key),
+                                            int(right_key))
+        # round the ends of the windows, which are exact in the finer unit
+        counts = self._impl.count_ranges(self._keys(xs - left, True),
+                                         self._keys(xs + right), (True, True))
+        counts[np.isnat(xs)] = 0
+        return counts
+
+    def isin(self, values, sort, threads):
+        keys, _, exact = self._bounds(values)
+        return self._impl.isin(keys, sort, threads) & exact.ravel()
+
+    def digitize(self, values, right, threads):
+        return self._impl.digitize(self._keys(values, right), right, threads)
+
+    def histogram(self, values, threads):
+        keys, _, exact = self._bounds(values)
+        if len(self._impl) > 0:
+            # the last bin is closed, but not beyond the last edge
+            keys = keys[exact | (keys != self._impl[len(self._impl) - 1])]
+        return self._impl.histogram(keys, threads)
+
+    def _nearest_between(self, x, ceil, k):
+        """Return the positions of the k elements closest to x, which falls
+        between two elements that are consecutive in the unit of the
+        elements, from the closest one and preferring the smaller on ties."""
+        import numpy as np
+        i = self._impl.bisect_left(ceil)
+        lo, hi = max(0, i - k), min(len(self._impl), i + k)
+        window = np.array([self._impl[j] for j in range(lo, hi)], np.int64)
+        distances = np.abs(self._elements(window) - x)
+        return lo + np.argsort(distances, kind='stable')[:k].astype(np.uint64)
+
+    def nearest(self, x, k):
+        import numpy as np
+        x = self._values(x)
+        floor, ceil, exact = self._bounds(x)
+        if exact or np.isnat(x):
+            positions, keys = self._impl.nearest(int(floor), k)
+            return positions, self._elements(keys)
+        positions = self._nearest_between(x, int(ceil), k)
+        keys = np.array([self._impl[i] for i in positions.tolist()], np.int64)
+        return positions, self._elements(keys)
+
+    def nearest_many(self, xs, k):
+        import numpy as np
+        xs = self._values(xs).ravel()
+        floors, ceilings, exact = self._bounds(xs)
+        positions, keys = self._impl.nearest_many(floors, k)
+        for i in np.flatnonzero(~exact & ~np.isnat(xs)):
+            positions[i] = self._nearest_between(xs[i], int(ceilings[i]), k)
+            keys[i] = [self._impl[j] for j in positions[i].tolist()]
+        return positions, self._elements(keys)
+
+    def asof(self, values, direction, tolerance):
+        import numpy as np
+        xs = self._values(values).ravel()
+        floors, ceilings, exact = self._bounds(xs)
+        if tolerance is not None:
+            tolerance = self._values(tolerance, self._delta)
+            key, _, tolerance_exact = self._bounds(tolerance, self._delta)
+        if exact.all() and (tolerance is None or tolerance_exact):
+            tolerance = None if tolerance is None else int(key)
+            positions, keys = self._impl.asof(floors, direction, tolerance)
+            return positions, self._elements(keys)
+        if direction not in ('backward', 'forward', 'nearest'):
+            raise ValueError(
+                "direction must be 'backward', 'forward' or 'nearest'")
+
+        # match the floors backward and the ceilings forward, then compare
+        # their distances from the values in the finer unit
+        backward, backward_keys = self._impl.asof(floors, 'backward', None)
+        forward, forward_keys = self._impl.asof(ceilings, 'forward', None)
+        backward_distances = xs - self._elements(backward_keys)
+        forward_distances = self._elements(forward_keys) - xs
+        has_backward = (backward >= 0) & (direction != 'forward')
+        has_forward = (forward >= 0) & (direction != 'backward')
+        take_forward = has_forward & (
+            ~has_backward | (forward_distances < backward_distances))
+        positions = np.where(take_forward, forward,
+                             np.where(has_backward, backward, -1))
+        if tolerance is not None:
+            distances = np.where(take_forward, forward_distances,
+                                 backward_distances)
+            positions[distances > tolerance] = -1
+        positions[np.isnat(xs)] = -1
+        keys = np.where(take_forward, forward_keys, backward_keys)
+        keys[positions < 0] = 0
+        return positions, self._elements(keys)
+
+    def segments(self):
+        keys, slopes, intercepts = self._impl.segments()
+        return self._elements(keys), slopes, intercepts
+
+    def merge(self, o, n):
+        return self._wrap(self._impl.merge(self._other(o, True), n))
+
+    def difference(self, o, n):
+        return self._wrap(self._impl.difference(self._other(o), n))
+
+    def symmetric_difference(self, o, n):
+        return self._wrap(self._impl.symmetric_difference(self._other(o, True),
+                                                          n))
+
+    def union(self, o, n):
+        return self._wrap(self._impl.union(self._other(o, True), n))
+
+    def intersection(self, o, n):
+        return self._wrap(self._impl.intersection(self._other(o), n))
+
+    def subset(self, o, n, proper):
+        return self._impl.subset(self._other(o), n, proper)
+
+    def superset(self, o, n, proper):
+        return self._impl.superset(self._other(o), n, proper)
+
+    def equal_to(self, o, n):
+        return self._impl.equal_to(self._other(o), n)
+
+    def not_equal_to(self, o, n):
+        return self._impl.not_equal_to(self._other(o), n)
+
+
 class SortedContainer(collections.abc.Sequence):
+    _compressions = {None: '', 'eliasfano': 'EliasFano',
+                     'residual': 'Residual', 'rle': 'RunLength',
+                     'hybrid': 'Hybrid'}
+    _impl_types = tuple(v for k, v in vars(_pygm).items()
+                        if k.startswith('PGMIndex'))
+
+    # Compressed storages are not available for 8- and 16-bit elements, so
+    # they fall back to the 32-bit classes listed after the native ones
+    _typecodes = {'B': ('UInt8', 'UInt32'), 'H': ('UInt16', 'UInt32'),
+                  'I': ('UInt32',), 'L': ('UInt64',), 'Q': ('UInt64',),
+                  'N': ('UInt64',), 'b': ('Int8', 'Int32'),
+                  'h': ('Int16', 'Int32'), 'i': ('Int32',), 'l': ('Int64',),
+                  'q': ('Int64',), 'n': ('Int64',), 'e': ('Float',),
+                  'f': ('Float',), 'd': ('Double',), 'QQ': ('Pair',),
+                  'uint128': ('UInt128',), 'S': ('Bytes',)}
+
     @staticmethod
-    def _fromtypecode(typecode, *args):
-        if typecode in 'BHI':
-            return _pygm.PGMIndexUInt32(*args)
-        elif typecode in 'LQN':
-            return _pygm.PGMIndexUInt64(*args)
-        elif typecode in 'bhi':
-            return _pygm.PGMIndexInt32(*args)
-        elif typecode in 'lqn':
-            return _pygm.PGMIndexInt64(*args)
-        elif typecode in 'ef':
-            return _pygm.PGMIndexFloat(*args)
-        elif typecode in 'd':
-            return _pygm.PGMIndexDouble(*args)
-        else:
-            raise TypeError('Unsupported typecode')
+    def _fromtypecode(typecode, compression, *args):
+        return SortedContainer._classfromtypecode(typecode, compression)(*args)
+
+    @staticmethod
+    def _temporal_dtype(typecode):
+        """Return the NumPy dtype of a datetime64 or timedelta64 typecode,
+        or None if ``typecode`` is of another type."""
+        if not isinstance(typecode, str) or \
+                not typecode.startswith(('M8', 'm8', 'datetime64',
+                                         'timedelta64')):
+            return None
+        import numpy as np
+        dtype = np.dtype(typecode)
+        if np.datetime_data(dtype)[0] == 'generic':
+            raise TypeError('Typecode %r needs a unit' % (typecode,))
+        return dtype
 
     @staticmethod
-    def _impl_or_iter(o):
+    def _typecodeofcolumn(column):
+        """Return the typecode of a NumPy array, and the array viewed as
+        int64 if it holds datetime64 or timedelta64 values."""
+        if column.dtype.kind not in 'mM':
+            return column.dtype.char, column
+        typecode = column.dtype.str[1:]
+        SortedContainer._temporal_dtype(typecode)
+        return typecode, _TemporalImpl._stored(column)
+
+    @staticmethod
+    def _classfromtypecode(typecode, compression):
+        if SortedContainer._temporal_dtype(typecode) is not None:
+            typecode = 'q'
+        if compression not in SortedContainer._compressions:
+            raise ValueError('Unsupported compression %r' % (compression,))
+        if typecode not in SortedContainer._typecodes:
+            raise TypeError('Unsupported typecode')
+
+        prefix = 'PGMIndex' + SortedContainer._compressions[compression]
+        for suffix in SortedContainer._typecodes[typecode]:
+            if hasattr(_pygm, prefix + suffix):
+                return getattr(_pygm, prefix + suffix)
+        raise TypeError('Typecode %r does not support compression %r' %
+                        (typecode, compression))
+
+    def _impl_or_iter(self, o):
         n = len(o) if hasattr(o, '__len__') else 0
-        o = o._impl if isinstance(o, SortedContainer) else iter(o)
+        same_impl = isinstance(o, SortedContainer) and \
+            type(o._impl) is type(self._impl)
+        o = o._impl if same_impl else iter(o)
         return (o, n)
 
     @staticmethod
-    def _initwitharg(self, o, typecode, epsilon, drop_duplicates):
-        has_len = hasattr(o, '__len__')
-        if o is None or (has_len and len(o) == 0):
-            self._typecode = 'q'
-            self._impl = _pygm.PGMIndexInt64()
-            return
-
+    def _initwitharg(self, o, typecode, epsilon, drop_duplicates,
+                     compression=None, quantize=False):
         # Init from internal _pygm objects
-        if isinstance(o, (_pygm.PGMIndexUInt32, _pygm.PGMIndexUInt64,
-                          _pygm.PGMIndexInt32, _pygm.PGMIndexInt64,
-                          _pygm.PGMIndexFloat, _pygm.PGMIndexDouble)):
+        if isinstance(o, SortedContainer._impl_types + (_TemporalImpl,)):
             assert not (drop_duplicates and o.has_duplicates())
+            dtype = SortedContainer._temporal_dtype(typecode)
+            if dtype is not None and not isinstance(o, _TemporalImpl):
+                o = _TemporalImpl(o, dtype)
             self._typecode = typecode
             self._impl = o
             return
 
+        # Init from datetime64 or timedelta64 values, stored as int64
+        dtype = SortedContainer._temporal_dtype(typecode)
+        if dtype is None and isinstance(o, SortedContainer):
+            dtype = SortedContainer._temporal_dtype(o._typecode)
+        elif dtype is None and getattr(o, 'dtype', None) is not None and \
+                o.dtype.kind in 'mM':
+            dtype = SortedContainer._temporal_dtype(o.dtype.str[1:])
+        if dtype is not None:
+            import numpy as np
+            values = np.asarray([] if o is None else o if hasattr(
+                o, '__len__') else list(o), dtype)
+            impl_type = SortedContainer._classfromtypecode('q', compression)
+            impl = impl_type.from_array(_TemporalImpl._stored(values),
+                                        drop_duplicates, epsilon, quantize)
+            self._typecode = dtype.str[1:]
+            self._impl = _TemporalImpl(impl, dtype)
+            return
+
+        if not typecode and compression == 'hybrid':
+            typecode = 'I'  # the only typecode of the hybrid storage
+        if o is None and typecode:
+            o = ()
+        has_len = hasattr(o, '__len__')
+        if not typecode and (o is None or (has_len and len(o) == 0)):
+            self._typecode = 'q'
+            self._impl = SortedContainer._fromtypecode('q', compression)
+            return
+
         # Init from an iterable
         is_iterable = isinstance(o, collections.abc.Iterable)
         if is_iterable:
             len_hint = len(o) if has_len else 0
-            args = (len_hint, drop_duplicates, epsilon)
-            tinit = SortedContainer._fromtypecode
+            args = (len_hint, drop_duplicates, epsilon, quantize)
+
+            def tinit(typecode, it):
+                return SortedContainer._fromtypecode(typecode, compression,
+                                                     it, *args)
 
             if typecode:  # user-provided typecode
                 self._typecode = typecode
-                self._impl = tinit(typecode, iter(o), *args)
+                self._impl = tinit(typecode, iter(o))
                 return
 
             try:  # try to get the typecode from memoryview
                 v = memoryview(o)
+                if v.format.endswith('s'):  # fixed-length bytes
+                    self._typecode = 'S'
+                    self._impl = tinit('S', iter(o))
+                    return
                 self._typecode = v.format
-                self._impl = tinit(v.format, iter(v), *args)
+                self._impl = tinit(v.format, iter(v))
                 return
             except TypeError:
                 pass
 
-            # Find the typecode by inspecting the type of the elements
+            # Find the typecode by inspecting the type of the elements, which
+            # takes several passes, so iterators are read into a list first
+            if not has_len:
+                o = list(o)
+                args = (len(o),) + args[1:]
             anyfloat = any(isinstance(x, float) for x in o)
-            self._typecode = 'd' if anyfloat else 'q'
-            self._impl = tinit(self._typecode, iter(o), *args)
+            anytuple = any(isinstance(x, tuple) for x in o)
+            anybytes = any(isinstance(x, bytes) for x in o)
+            self._typecode = 'QQ' if anytuple else 'S' if anybytes else \
+                'd' if anyfloat else 'q'
+            self._impl = tinit(self._typecode, iter(o))
             return
 
         raise TypeError('Unsupported argument type')
@@ -200,6 +624,448 @@ class SortedContainer(collections.abc.Sequence):
         """
         return self._impl.count(x)
 
+    def quantile(self, q):
+        """Return the ``q``-th quantile of the elements.
+
+        The quantile is computed as in :func:`numpy.quantile`, interpolating
+        linearly between the two closest elements, which are accessed by
+        position without scanning the container.
+
+        Args:
+            q (float): quantile to compute, between 0 and 1 inclusive
+
+        Returns:
+            float: the ``q``-th quantile
+
+        Raises:
+            ValueError: if the container is empty or ``q`` is not in [0, 1]
+        """
+        return self._impl.quantile(q)
+
+    def quantiles(self, qs):
+        """Return the quantiles of the elements for each value in ``qs``.
+
+        See :func:`quantile`. The quantiles are computed without holding the
+        GIL.
+
+        Args:
+            qs (array-like): quantiles to compute, between 0 and 1 inclusive
+
+        Returns:
+            numpy.ndarray: the quantiles
+
+        Raises:
+            ValueError: if the container is empty or some value of ``qs`` is
+                not in [0, 1]
+        """
+        return self._impl.quantiles(qs)
+
+    def cdf(self, xs, approximate=False):
+        """Return the empirical cumulative distribution function of the
+        elements at each value in ``xs``, that is, the fraction of the
+        elements smaller than or equal to each value.
+
+        The values are computed without holding the GIL.
+
+        Args:
+            xs (array-like): values at which to evaluate the function
+            approximate (bool, optional): whether to use the positions
+                predicted by the index, as in :func:`approx_ranks`, instead of
+                the exact ones. Defaults to False.
+
+        Returns:
+            numpy.ndarray: the fractions, between 0 and 1
+
+        Raises:
+            ValueError: if the container is empty
+        """
+        return self._impl.cdf(xs, approximate)
+
+    def segments(self):
+        """Return the segments of the last level of the index, which map each
+        element to an approximation of its position.
+
+        The ``i``-th segment covers the values from ``keys[i]`` up to
+        ``keys[i + 1]`` (excluded), and predicts the position of a value ``x``
+        as ``intercepts[i] + slopes[i] * (x - keys[i])``. For containers with
+        run-length compression, the positions are those of the distinct
+        elements. Views return the segments of the whole container.
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray, numpy.ndarray]: the first keys,
+            the slopes and the intercepts of the segments
+        """
+        return self._impl.segments()
+
+    def approx_rank(self, x):
+        """Return an approximation of :func:`bisect_left` for ``x``, computed
+        from the index alone without accessing the elements.
+
+        The exact position lies in the returned bounds, which are at most
+        about ``2 * epsilon`` apart.
+
+        Args:
+            x: value to search
+
+        Returns:
+            tuple[int, int, int]: approximate position, and lower and upper
+            bound (both inclusive) of the exact position
+        """
+        return self._impl.approx_rank(x)
+
+    def approx_ranks(self, xs):
+        """Return an approximation of :func:`bisect_left` for each value in
+        ``xs``, computed from the index alone without accessing the elements.
+
+        The approximations are computed without holding the GIL.
+
+        Args:
+            xs (array-like): values to search
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray, numpy.ndarray]: approximate
+            positions, and lower and upper bounds (both inclusive) of the
+            exact positions
+        """
+        return self._impl.approx_ranks(xs)
+
+    def nearest(self, x, k=1):
+        """Return the ``k`` elements closest to ``x``.
+
+        The elements are sorted by their distance from ``x``, and the smaller
+        one comes first on ties.
+
+        Args:
+            x: value to search
+            k (int, optional): number of elements to return, which is reduced
+                to the length of the container if larger. Defaults to 1.
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray]: the positions and the values
+            of the elements
+        """
+        return self._impl.nearest(x, k)
+
+    def nearest_many(self, xs, k=1):
+        """Return the ``k`` elements closest to each value in ``xs``.
+
+        See :func:`nearest`. The elements are found without holding the GIL.
+
+        Args:
+            xs (array-like): values to search
+            k (int, optional): number of elements to return for each value,
+                which is reduced to the length of the container if larger.
+                Defaults to 1.
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray]: the positions and the values
+            of the elements, with a row for each value in ``xs``
+        """
+        return self._impl.nearest_many(xs, k)
+
+    def asof(self, values, direction='backward', tolerance=None):
+        """Match each value in ``values`` with an element of this container,
+        as in an as-of join.
+
+        The match is the last element smaller than or equal to the value if
+        ``direction`` is ``'backward'`` (as :func:`find_le`), the first element
+        greater than or equal to it if ``'forward'`` (as :func:`find_ge`), or
+        the closest of the two if ``'nearest'``, preferring the backward one on
+        ties. The matches are computed without holding the GIL, and are
+        faster if ``values`` is sorted.
+
+        Args:
+            values (array-like): values to match
+            direction (str, optional): ``'backward'``, ``'forward'`` or
+                ``'nearest'``. Defaults to ``'backward'``.
+            tolerance (optional): maximum distance between a value and its
+                match. Defaults to None, i.e. no limit.
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray]: the positions of the matches,
+            or -1 for the values without a match, and the matched elements,
+            or 0 for the values without a match
+
+        Raises:
+            ValueError: if ``direction`` is not valid
+        """
+        return self._impl.asof(values, direction, tolerance)
+
+    def row_ids(self):
+        """Return the position in the original column of each element, for a
+        container built with :func:`SortedList.from_column`.
+
+        Returns:
+            numpy.ndarray: the permutation that sorts the column
+
+        Raises:
+            ValueError: if the container was not built from a column
+        """
+        return self._impl.row_ids(0, len(self))
+
+    def range_row_ids(self, a, b, inclusive=(True, True)):
+        """Return the position in the original column of the elements between
+        ``a`` and ``b``, for a container built with
+        :func:`SortedList.from_column`.
+
+        The positions are sorted by element, and equal elements are sorted by
+        position.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            numpy.ndarray: positions in the column
+
+        Raises:
+            ValueError: if the container was not built from a column
+        """
+        i = self.bisect_left(a) if inclusive[0] else self.bisect_right(a)
+        j = self.bisect_right(b) if inclusive[1] else self.bisect_left(b)
+        return self._impl.row_ids(i, max(i, j))
+
+    def equal_row_ids(self, x):
+        """Return the positions in the original column of the elements equal
+        to ``x``, in increasing order, for a container built with
+        :func:`SortedList.from_column`.
+
+        Args:
+            x: value to search
+
+        Returns:
+            numpy.ndarray: positions in the column
+
+        Raises:
+            ValueError: if the container was not built from a column
+        """
+        return self.range_row_ids(x, x)
+
+    def isin(self, values, sort=False, threads=1):
+        """Return whether each value in ``values`` is in the container.
+
+        The values are probed without holding the GIL. They are not cast to
+        the type of the elements: a value that no element can equal, such as
+        a fraction or a number out of the range of the type, is never in the
+        container. Byte strings are matched with their trailing null bytes,
+        except in a NumPy array of fixed-length bytes, where NumPy takes them
+        as padding.
+
+        Args:
+            values (array-like): values to search
+            sort (bool, optional): whether to probe the values in sorted
+                order, which gives faster searches on large unsorted inputs at
+                the cost of sorting them. Defaults to False.
+            threads (int, optional): number of threads to use, if the module
+                was compiled with OpenMP. Defaults to 1.
+
+        Returns:
+            numpy.ndarray: boolean mask of the values in the container
+        """
+        return self._impl.isin(values, sort, threads)
+
+    def filter_in(self, values, sort=False, threads=1):
+        """Return the values in ``values`` that are in the container, in their
+        original order.
+
+        See :func:`isin` for the arguments.
+
+        Returns:
+            numpy.ndarray: values in the container
+        """
+        import numpy as np
+        mask = self.isin(values, sort, threads)
+        return np.asarray(values)[mask]
+
+    def filter_out(self, values, sort=False, threads=1):
+        """Return the values in ``values`` that are not in the container, in
+        their original order.
+
+        See :func:`isin` for the arguments.
+
+        Returns:
+            numpy.ndarray: values not in the container
+        """
+        import numpy as np
+        mask = self.isin(values, sort, threads)
+        return np.asarray(values)[~mask]
+
+    def window_counts(self, xs, left, right=None):
+        """Return the number of elements in the window ``[x - left, x + right]``
+        around each value ``x`` in ``xs``.
+
+        The counts are computed without holding the GIL. If ``xs`` is sorted,
+        the bounds of each window are searched forward from those of the
+        previous one.
+
+        Args:
+            xs (array-like): centres of the windows
+            left: distance of the lower bound of the windows from their centre
+            right (optional): distance of the upper bound of the windows from
+                their centre. Defaults to None, i.e. the same as ``left``.
+
+        Returns:
+            numpy.ndarray: number of elements in each window
+        """
+        return self._impl.window_counts(xs, left, right)
+
+    def digitize(self, values, right=False, threads=1):
+        """Return the index of the bin of each value in ``values``, using the
+        elements of this container as bin edges.
+
+        The result is the same as ``numpy.digitize(values, self, right)``,
+        i.e. :func:`bisect_right` (or :func:`bisect_left` if ``right`` is
+        True) of each value. The positions are computed without holding the
+        GIL.
+
+        Args:
+            values (array-like): values to bucket
+            right (bool, optional): whether the bins include their right edge
+                instead of their left one. Defaults to False.
+            threads (int, optional): number of threads to use, if the module
+                was compiled with OpenMP. Defaults to 1.
+
+        Returns:
+            numpy.ndarray: index of the bin of each value
+        """
+        return self._impl.digitize(values, right, threads)
+
+    def histogram(self, values, threads=1):
+        """Return the number of values in ``values`` that fall in each bin,
+        using the elements of this container as bin edges.
+
+        The result is the same as the counts returned by
+        ``numpy.histogram(values, bins=self)``: the ``i``-th bin is
+        ``[self[i], self[i + 1])``, except the last one, which includes its
+        right edge, and the values outside the edges are ignored. The counts
+        are accumulated without holding the GIL.
+
+        Args:
+            values (array-like): values to count
+            threads (int, optional): number of threads to use, if the module
+                was compiled with OpenMP. Defaults to 1.
+
+        Returns:
+            numpy.ndarray: ``len(self) - 1`` counts
+        """
+        return self._impl.histogram(values, threads)
+
+    def count_range(self, a, b, inclusive=(True, True)):
+        """Return the number of elements between ``a`` and ``b``.
+
+        The count is computed from two searches, without iterating over the
+        elements.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            int: number of elements between the given bounds
+        """
+        return self._impl.count_range(a, b, inclusive)
+
+    def count_ranges(self, starts, ends, inclusive=(True, True)):
+        """Return the number of elements between each pair of bounds in
+        ``starts`` and ``ends``.
+
+        The counts are computed without holding the GIL. The bounds may be any
+        numbers, which are compared exactly with the elements.
+
+        Args:
+            starts (array-like): lower bound values
+            ends (array-like): upper bound values, as many as ``starts``
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            numpy.ndarray: number of elements between each pair of bounds
+        """
+        return self._impl.count_ranges(starts, ends, inclusive)
+
+    def range_sum(self, a, b, inclusive=(True, True)):
+        """Return the sum of the elements between ``a`` and ``b``.
+
+        The first call computes the prefix sums of the elements, which take
+        8 or 16 bytes per element; then each call takes constant time after
+        the two searches for the bounds. The sum is exact for integer
+        elements.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            int or float: sum of the elements between the given bounds
+        """
+        return self._impl.range_sum(a, b, inclusive)
+
+    def range_mean(self, a, b, inclusive=(True, True)):
+        """Return the arithmetic mean of the elements between ``a`` and
+        ``b``, or ``nan`` if there are none.
+
+        See :func:`range_sum` for the cost of the query.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            float: mean of the elements between the given bounds
+        """
+        return self._impl.range_mean(a, b, inclusive)
+
+    def range_sums(self, starts, ends, inclusive=(True, True)):
+        """Return the sum of the elements between each pair of bounds in
+        ``starts`` and ``ends``.
+
+        The sums are computed without holding the GIL. They are exact for
+        integer elements, in an array of 64-bit integers, or of Python ints if
+        some sum does not fit in 64 bits; they are floats otherwise.
+
+        Args:
+            starts (array-like): lower bound values
+            ends (array-like): upper bound values, as many as ``starts``
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            numpy.ndarray: sum of the elements between each pair of bounds
+        """
+        return self._impl.range_sums(starts, ends, inclusive, False)
+
+    def range_means(self, starts, ends, inclusive=(True, True)):
+        """Return the arithmetic mean of the elements between each pair of
+        bounds in ``starts`` and ``ends``, or ``nan`` where there are none.
+
+        The means are computed without holding the GIL.
+
+        Args:
+            starts (array-like): lower bound values
+            ends (array-like): upper bound values, as many as ``starts``
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            numpy.ndarray: mean of the elements between each pair of bounds
+        """
+        return self._impl.range_sums(starts, ends, inclusive, True)
+
     def range(self, a, b, inclusive=(True, True), reverse=False):
         """Return an iterator over elements between ``a`` and ``b``.
 
@@ -217,6 +1083,123 @@ class SortedContainer(collections.abc.Sequence):
         """
         return self._impl.range(a, b, inclusive, reverse)
 
+    def iter_chunks(self, chunk_size=65536):
+        """Return an iterator over the elements of ``self`` in read-only
+        NumPy arrays of ``chunk_size`` elements (the last one may be
+        shorter).
+
+        For uncompressed containers, the arrays are views of the elements
+        without a copy. For compressed containers, each array is decoded on
+        demand, so only one chunk at a time is kept in memory.
+
+        Args:
+            chunk_size (int, optional): number of elements per array.
+                Defaults to 65536.
+
+        Returns:
+            iterator over ``numpy.ndarray`` objects
+        """
+        return self._chunks(0, len(self), chunk_size)
+
+    def range_chunks(self, a, b, chunk_size=65536, inclusive=(True, True)):
+        """Return an iterator over the elements between ``a`` and ``b`` in
+        read-only NumPy arrays of ``chunk_size`` elements (the last one may
+        be shorter).
+
+        See :func:`iter_chunks` for the memory behaviour of the arrays.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            chunk_size (int, optional): number of elements per array.
+                Defaults to 65536.
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            iterator over ``numpy.ndarray`` objects
+        """
+        i = self.bisect_left(a) if inclusive[0] else self.bisect_right(a)
+        j = self.bisect_right(b) if inclusive[1] else self.bisect_left(b)
+        return self._chunks(i, j, chunk_size)
+
+    def _chunks(self, i, j, chunk_size):
+        import numpy as np
+        if chunk_size < 1:
+            raise ValueError('chunk_size must be positive')
+        try:
+            data = self._asarray()
+        except TypeError:
+            data = None
+
+        def generator():
+            for start in range(i, j, chunk_size):
+                stop = min(start + chunk_size, j)
+                if data is not None:
+                    yield data[start:stop]
+                else:
+                    chunk = self._decode(start, stop)
+                    chunk.flags.writeable = False
+                    yield chunk
+
+        return generator()
+
+    def _asarray(self):
+        if isinstance(self._impl, _TemporalImpl):
+            return self._impl.asarray()
+        import numpy as np
+        return np.asarray(memoryview(self._impl))
+
+    def _decode(self, i, j):
+        import numpy as np
+        out = np.empty(j - i, self._impl.format())
+        self._impl.decode(out, i)
+        return out
+
+    def range_view(self, a, b, inclusive=(True, True)):
+        """Return a view of the elements between ``a`` and ``b``.
+
+        The view shares the elements and the index of ``self`` without a
+        copy, so it takes constant space.
+
+        Args:
+            a: lower bound value
+            b: upper bound value
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            SortedView: view of the elements between the given bounds
+        """
+        i = self.bisect_left(a) if inclusive[0] else self.bisect_right(a)
+        j = self.bisect_right(b) if inclusive[1] else self.bisect_left(b)
+        return self._view(i, j)
+
+    def slice_view(self, start=None, stop=None):
+        """Return a view of the elements at positions from ``start``
+        (inclusive) to ``stop`` (exclusive).
+
+        The view shares the elements and the index of ``self`` without a
+        copy, so it takes constant space. Negative positions count from the
+        end, as in slices.
+
+        Args:
+            start (int, optional): first position. Defaults to None.
+            stop (int, optional): position after the last one. Defaults to
+                None.
+
+        Returns:
+            SortedView: view of the elements at the given positions
+        """
+        i, j, _ = slice(start, stop).indices(len(self))
+        return self._view(i, j)
+
+    def _view(self, i, j):
+        from .sortedview import SortedView
+        return SortedView(self._impl.view(i, max(i, j)), self._typecode)
+
     def index(self, x, start=None, stop=None):
         """Return the first index of ``x``.
 
@@ -245,6 +1228,8 @@ class SortedContainer(collections.abc.Sequence):
         * ``'leaf segments'`` number of segments in the last level of the index
         * ``'height'`` number of levels of the index
         * ``'epsilon'`` value of the trade-off parameter of the index
+        * ``'quantized'`` whether the index is quantized
+        * ``'quantization error'`` additional error of the quantized index
         * ``'typecode'`` type of the elements
 
         Returns:
@@ -274,6 +1259,56 @@ class SortedContainer(collections.abc.Sequence):
         """
         return self._impl.__reversed__()
 
+    def __buffer__(self, flags):
+        """Return a read-only memoryview of the elements of ``self``.
+
+        The memoryview shares the memory of ``self`` without a copy, and it
+        keeps ``self`` alive. Compressed containers do not support the buffer
+        protocol.
+
+        ``self.__buffer__(flags)`` <==> ``memoryview(self)`` (Python 3.12+)
+
+        Args:
+            flags (int): flags of the buffer request
+
+        Returns:
+            memoryview: read-only view of the elements
+
+        Raises:
+            TypeError: if ``self`` is compressed
+        """
+        return memoryview(self._impl)
+
+    def __array__(self, dtype=None, copy=None):
+        """Return a NumPy array of the elements of ``self``.
+
+        For uncompressed containers, the array is a read-only view of the
+        elements without a copy, unless ``dtype`` or ``copy`` require one.
+        For compressed containers, the elements are decoded into a new array.
+
+        ``self.__array__()`` <==> ``numpy.asarray(self)``
+
+        Args:
+            dtype (numpy.dtype, optional): type of the array. Defaults to
+                the type of the elements.
+            copy (bool, optional): whether to copy the elements. Defaults to
+                None.
+
+        Returns:
+            numpy.ndarray: array of the elements
+        """
+        import numpy as np
+        try:
+            a = self._asarray()
+        except TypeError:
+            if copy is False:
+                raise ValueError('a compressed container cannot be '
+                                 'exported without a copy')
+            a = self._decode(0, len(self))
+        if dtype is not None and a.dtype != dtype:
+            return a.astype(dtype)
+        return a.copy() if copy else a
+
     def __repr__(self):
         """Return a string representation of self.
 
@@ -287,8 +1322,10 @@ class SortedContainer(collections.abc.Sequence):
             preview += repr(list(self._impl))
         else:
             fmt_args = (self[0], self[1], self[2], self[-2], self[-1])
-            if self._typecode in 'fd':
+            if self._typecode in ('f', 'd'):
                 preview += '[%g, %g, %g, ..., %g, %g]' % fmt_args
-            else:
+            elif isinstance(self[0], int):
                 preview += '[%d, %d, %d, ..., %d, %d]' % fmt_args
+            else:
+                preview += '[%r, %r, %r, ..., %r, %r]' % fmt_args
         return '%s(%s)' % (self.__class__.__name__, preview)
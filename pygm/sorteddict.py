@@ -0,0 +1,389 @@
+import collections.abc
+
+from .sortedcontainer import SortedContainer
+from .sortedset import SortedSet
+
+
+class SortedDict(collections.abc.Mapping):
+    """A sorted mapping from keys to values with efficient query performance
+    and memory usage.
+
+    The keys are stored in a :class:`SortedSet`, and the values in a NumPy
+    array whose ``i``-th entry is the value of the ``i``-th smallest key. The
+    values are permuted together with the keys while they are sorted, and
+    they can have any NumPy dtype and shape, provided that their first
+    dimension matches the number of keys.
+
+    The mapping is initialised with the content of ``arg``, which is either a
+    mapping, an iterable of key-value pairs or, if ``values`` is given, an
+    array-like of keys. If a key occurs more than once, its last value is
+    kept.
+
+    The ``typecode``, ``epsilon``, ``compression`` and ``quantize``
+    arguments are the same of :class:`SortedSet`. The ``threads`` argument
+    gives the number of threads used to sort the keys, if the module was
+    compiled with OpenMP.
+
+    Methods for accessing and querying items:
+
+    * :func:`SortedDict.__getitem__`
+    * :func:`SortedDict.__contains__`
+    * :func:`SortedDict.get`
+    * :func:`SortedDict.get_many`
+    * :func:`SortedDict.keys`
+    * :func:`SortedDict.values`
+    * :func:`SortedDict.range_items`
+
+    Methods for set operations on the keys, which carry the values:
+
+    * :func:`SortedDict.difference` (alias for ``dict - other``)
+    * :func:`SortedDict.intersection` (alias for ``dict & other``)
+    * :func:`SortedDict.union` (alias for ``dict | other``)
+    * :func:`SortedDict.symmetric_difference` (alias for ``dict ^ other``)
+
+    Other methods:
+
+    * :func:`SortedDict.stats`
+    * :func:`SortedDict.__repr__`
+
+    Args:
+        arg (mapping, iterable or array-like, optional): initial items, or
+            initial keys if ``values`` is given. Defaults to None.
+        values (array-like, optional): initial values, as many as the keys
+            in ``arg``. Defaults to None.
+        typecode (char, optional): type of the stored keys. Defaults to
+            None.
+        epsilon (int, optional): space-time trade-off parameter. Defaults
+            to 64.
+        compression (str, optional): storage format of the keys, as in
+            :class:`SortedSet`. Defaults to None.
+        quantize (bool, optional): whether to quantize the index. Defaults
+            to False.
+        threads (int, optional): number of threads used for sorting. Defaults
+            to 1.
+
+    Example:
+        >>> from pygm import SortedDict
+        >>> sd = SortedDict([3, 1, 2, 1], values=[30., 10., 20., 11.])
+        >>> sd
+        SortedDict({1: 11.0, 2: 20.0, 3: 30.0})
+        >>> 2 in sd, sd.get(4)
+        (True, None)
+        >>> sd.get_many([3, 1, 5], default=0)
+        array([30., 11.,  0.])
+        >>> keys, values = sd.range_items(2, 3)
+        >>> keys.tolist(), values.tolist()
+        ([2, 3], [20.0, 30.0])
+    """
+
+    def __init__(self, arg=None, values=None, typecode=None, epsilon=64,
+                 compression=None, quantize=False, threads=1):
+        import numpy as np
+        if values is not None:
+            keys = arg
+        elif isinstance(arg, SortedDict):
+            keys, values = arg._keys._decode(0, len(arg)), arg._values
+        else:
+            items = arg.items() if isinstance(arg, collections.abc.Mapping) \
+                else arg or []
+            pairs = list(items)
+            keys = [k for k, _ in pairs]
+            values = [v for _, v in pairs]
+
+        keys = np.asarray(keys, dtype=typecode)
+        if typecode is None and len(keys) == 0:
+            keys = keys.astype('q')
+        values = np.asarray(values)
+        if keys.ndim != 1 or values.ndim == 0 or len(keys) != len(values):
+            raise ValueError('keys and values must have the same length')
+
+        typecode = keys.dtype.char
+        if keys.dtype.kind in 'mM':
+            typecode = keys.dtype.str[1:]
+        impl_type = SortedContainer._classfromtypecode(typecode, compression)
+        self._build(impl_type, typecode, keys, values, epsilon, quantize,
+                    threads)
+
+    def _build(self, impl_type, typecode, keys, values, epsilon, quantize,
+               threads):
+        _, keys = SortedContainer._typecodeofcolumn(keys)
+        impl = impl_type.from_column(keys, True, epsilon, quantize, threads)
+        self._impl_type = impl_type
+        self._keys = SortedSet(impl, typecode)
+        self._values = values[impl.row_ids(0, len(impl))]
+        self._values.flags.writeable = False
+
+    def _derive(self, keys, values):
+        stats = self._keys.stats()
+        d = SortedDict.__new__(SortedDict)
+        d._build(self._impl_type, self._keys._typecode, keys, values,
+                 stats['epsilon'], bool(stats['quantized']), 1)
+        return d
+
+    def _positions(self, keys):
+        import numpy as np
+        impl = self._keys._impl
+        positions = impl.asof(keys, 'forward', 0)[0]
+        # asof casts the keys to the key type, so 1.5 would find the key 1
+        return np.where(impl.isin(keys, False, 1), positions, -1)
+
+    def __len__(self):
+        """Return the number of items.
+
+        ``self.__len__()`` <==> ``len(self)``
+
+        Returns:
+            int: number of items
+        """
+        return len(self._keys)
+
+    def __iter__(self):
+        """Return an iterator over the keys in sorted order.
+
+        ``self.__iter__()`` <==> ``iter(self)``
+
+        Returns:
+            iterator: an iterator over the keys
+        """
+        return iter(self._keys)
+
+    def __contains__(self, key):
+        """Return ``True`` if and only if ``key`` is a key of the mapping.
+
+        ``self.__contains__(key)`` <==> ``key in self``
+
+        Args:
+            key: key to search
+
+        Returns:
+            bool: whether ``key`` is a key of the mapping
+        """
+        return key in self._keys
+
+    def __getitem__(self, key):
+        """Return the value of ``key``.
+
+        ``self.__getitem__(key)`` <==> ``self[key]``
+
+        Args:
+            key: key to search
+
+        Returns:
+            value of ``key``
+
+        Raises:
+            KeyError: if ``key`` is not in the mapping
+        """
+        i = self._keys.bisect_left(key)
+        if i == self._keys.bisect_right(key):
+            raise KeyError(key)
+        return self._values[i]
+
+    def get_many(self, keys, default=None):
+        """Return the value of each key in ``keys``.
+
+        The keys are searched without holding the GIL.
+
+        Args:
+            keys (array-like): keys to search
+            default (optional): value returned for the keys that are not in
+                the mapping. Defaults to None, i.e. raise an exception.
+
+        Returns:
+            numpy.ndarray: the values of the keys
+
+        Raises:
+            KeyError: if some key is not in the mapping and ``default`` is
+                None
+        """
+        import numpy as np
+        keys = np.asarray(keys)
+        positions = self._positions(keys)
+        found = positions >= 0
+        if default is None and not found.all():
+            raise KeyError(keys[~found][0].item())
+        if len(self) == 0:
+            shape = (len(positions),) + self._values.shape[1:]
+            return np.full(shape, default, dtype=self._values.dtype)
+        out = self._values[np.where(found, positions, 0)]
+        if not found.all():
+            out[~found] = default
+        return out
+
+    def keys(self):
+        """Return the keys in sorted order.
+
+        Returns:
+            SortedSet: the keys, which share the storage of the mapping
+        """
+        return self._keys
+
+    def values(self):
+        """Return the values, in the order of their keys.
+
+        Returns:
+            numpy.ndarray: a read-only array of the values
+        """
+        return self._values
+
+    def range_items(self, a=None, b=None, inclusive=(True, True)):
+        """Return the items whose key is between ``a`` and ``b``.
+
+        Args:
+            a (optional): lower bound key. Defaults to None, i.e. no bound.
+            b (optional): upper bound key. Defaults to None, i.e. no bound.
+            inclusive (tuple[bool, bool], optional): a pair of boolean
+                indicating whether the bounds are inclusive (``True``) or
+                exclusive (``False``). Defaults to ``(True, True)``.
+
+        Returns:
+            tuple[numpy.ndarray, numpy.ndarray]: the keys and the values of
+            the items
+        """
+        i, j = 0, len(self)
+        if a is not None:
+            i = self._keys.bisect_left(a) if inclusive[0] else \
+                self._keys.bisect_right(a)
+        if b is not None:
+            j = self._keys.bisect_right(b) if inclusive[1] else \
+                self._keys.bisect_left(b)
+        j = max(i, j)
+        return self._keys._decode(i, j), self._values[i:j]
+
+    def _other_keys(self, other):
+        if isinstance(other, SortedDict):
+            return other._keys
+        if isinstance(other, SortedSet):
+            return other
+        return SortedSet(other, self._keys._typecode)
+
+    def _coerce(self, other):
+        if isinstance(other, SortedDict):
+            return other
+        return SortedDict(other, typecode=self._keys._typecode)
+
+    def union(self, other):
+        """Return a new ``SortedDict`` with the items of ``self`` and
+        ``other``, taking the value from ``other`` for the keys in both.
+
+        ``self.union(other)`` <==> ``self | other``
+
+        Args:
+            other (mapping): a mapping or an iterable of key-value pairs
+
+        Returns:
+            SortedDict: new mapping with the items of both mappings
+        """
+        import numpy as np
+        other = self._coerce(other)
+        keys = np.concatenate((self._keys._decode(0, len(self)),
+                               other._keys._decode(0, len(other))))
+        values = np.concatenate((self._values, other._values))
+        return self._derive(keys, values)
+
+    def intersection(self, other):
+        """Return a new ``SortedDict`` with the items of ``self`` whose key
+        is also in ``other``.
+
+        ``self.intersection(other)`` <==> ``self & other``
+
+        Args:
+            other (iterable): a mapping or an iterable of keys
+
+        Returns:
+            SortedDict: new mapping with the items whose key is in ``other``
+        """
+        mask = self._other_keys(other).isin(self._keys._decode(0, len(self)))
+        return self._derive(self._keys._decode(0, len(self))[mask],
+                            self._values[mask])
+
+    def difference(self, other):
+        """Return a new ``SortedDict`` with the items of ``self`` whose key
+        is not in ``other``.
+
+        ``self.difference(other)`` <==> ``self - other``
+
+        Args:
+            other (iterable): a mapping or an iterable of keys
+
+        Returns:
+            SortedDict: new mapping with the items whose key is not in
+            ``other``
+        """
+        mask = self._other_keys(other).isin(self._keys._decode(0, len(self)))
+        return self._derive(self._keys._decode(0, len(self))[~mask],
+                            self._values[~mask])
+
+    def symmetric_difference(self, other):
+        """Return a new ``SortedDict`` with the items whose key is in exactly
+        one of ``self`` and ``other``.
+
+        ``self.symmetric_difference(other)`` <==> ``self ^ other``
+
+        Args:
+            other (mapping): a mapping or an iterable of key-value pairs
+
+        Returns:
+            SortedDict: new mapping with the items whose key is in exactly
+            one of the mappings
+        """
+        other = self._coerce(other)
+        return self.difference(other).union(other.difference(self))
+
+    __or__ = union
+    __and__ = intersection
+    __sub__ = difference
+    __xor__ = symmetric_difference
+
+    def __eq__(self, other):
+        """Return ``True`` if and only if ``self`` and ``other`` have the same
+        items.
+
+        ``self.__eq__(other)`` <==> ``self == other``
+
+        Args:
+            other (mapping): a mapping
+
+        Returns:
+            bool: whether the mappings are equal
+        """
+        if isinstance(other, SortedDict):
+            import numpy as np
+            return self._keys == other._keys and \
+                np.array_equal(self._values, other._values)
+        return collections.abc.Mapping.__eq__(self, other)
+
+    def __ne__(self, other):
+        return not self == other
+
+    __hash__ = None
+
+    def stats(self):
+        """Return a dict containing statistics about the mapping.
+
+        The entries are those of :func:`SortedSet.stats` for the keys, and:
+
+        * ``'values size'`` size of the values in bytes
+
+        Returns:
+            dict[str, object]: a dictionary of stats about the mapping
+        """
+        d = self._keys.stats()
+        d['values size'] = self._values.nbytes
+        return d
+
+    def __repr__(self):
+        """Return a string representation of self.
+
+        ``self.__repr__()`` <==> ``repr(self)``
+
+        Returns:
+            str: repr(self)
+        """
+        n = len(self)
+        shown = range(n) if n < 6 else (0, 1, 2, n - 2, n - 1)
+        items = ['%r: %r' % (self._keys[i], self._values[i].tolist())
+                 for i in shown]
+        if n >= 6:
+            items.insert(3, '...')
+        return '%s({%s})' % (self.__class__.__name__, ', '.join(items))
@@ -16,9 +16,52 @@ class SortedList(SortedContainer):
     standard library.  If no type code is specified, the type is inferred
     from the contents of ``arg``.
 
+    Two further type codes store 128-bit elements: ``'QQ'`` for pairs of
+    unsigned 64-bit integers such as ``(tenant_id, timestamp)``, which are
+    ordered lexicographically and returned as tuples, and ``'uint128'`` for
+    unsigned 128-bit integers such as the ``int`` attribute of UUIDs. Both
+    also accept 16 bytes in big-endian order, e.g. ``uuid.bytes``. The index
+    is built on a 64-bit projection of the elements, and these containers
+    support the methods that do not need arithmetic on the elements.
+
+    The ``'S'`` type code stores byte strings, such as ticker symbols,
+    hashes or ISO dates, one after the other in a single buffer. The index is
+    built on the 8 bytes that follow the prefix shared by all the elements,
+    and the lookups compare the full strings only near the predicted
+    position. :func:`digitize` and :func:`isin` also accept NumPy arrays of
+    fixed-length bytes, which are searched without converting each value to
+    a Python object.
+
+    NumPy arrays of ``datetime64`` or ``timedelta64`` values, or type codes
+    such as ``'M8[ns]'`` and ``'m8[s]'``, store the elements as 64-bit
+    integers in the unit of the dtype. The queries accept datetimes, strings
+    and NumPy scalars, and return elements and arrays of the same dtype;
+    arrays are viewed in place rather than converted value by value. Values
+    of a finer unit are compared exactly rather than truncated to the unit
+    of the dtype. ``NaT`` cannot be stored and raises ValueError; it is never
+    in the container.
+
     The ``epsilon`` argument allows to trade off memory usage with query
     performance. The default value is adequate in most cases.
 
+    The ``compression`` argument selects how the elements are stored. With
+    ``'eliasfano'``, integer elements are kept in Elias-Fano encoded form,
+    which takes about ``2 + log2(u/n)`` bits per element, where ``u`` is the
+    difference between the largest and the smallest element. Queries keep
+    their interface and become slightly slower because each accessed element
+    is decoded on the fly. With ``'residual'``, each segment of the index is
+    used to predict the integer elements from their positions, and only the
+    bit-packed prediction errors are stored. The smaller the ``epsilon``, the
+    smaller the errors, so this compression pays off on data that the index
+    approximates well. With ``'rle'``, each distinct element is stored once
+    together with the number of its occurrences, and only the distinct
+    elements are indexed, which suits lists with many duplicates.
+
+    The ``quantize`` argument stores the index with single-precision slopes
+    and with 32-bit intercepts and relative keys, which makes it smaller and
+    more cache-friendly. The search range of the index is widened by the
+    rounding error, so queries stay exact.
+
     Methods for adding and removing elements:
 
     * :func:`SortedList.__add__`
@@ -31,7 +74,31 @@ class SortedList(SortedContainer):
     * :func:`SortedList.__contains__`
     * :func:`SortedList.bisect_left`
     * :func:`SortedList.bisect_right`
+    * :func:`SortedList.quantile`
+    * :func:`SortedList.quantiles`
+    * :func:`SortedList.cdf`
+    * :func:`SortedList.segments`
+    * :func:`SortedList.approx_rank`
+    * :func:`SortedList.approx_ranks`
     * :func:`SortedList.count`
+    * :func:`SortedList.nearest`
+    * :func:`SortedList.nearest_many`
+    * :func:`SortedList.asof`
+    * :func:`SortedList.row_ids`
+    * :func:`SortedList.range_row_ids`
+    * :func:`SortedList.equal_row_ids`
+    * :func:`SortedList.isin`
+    * :func:`SortedList.filter_in`
+    * :func:`SortedList.filter_out`
+    * :func:`SortedList.window_counts`
+    * :func:`SortedList.digitize`
+    * :func:`SortedList.histogram`
+    * :func:`SortedList.count_range`
+    * :func:`SortedList.count_ranges`
+    * :func:`SortedList.range_sum`
+    * :func:`SortedList.range_mean`
+    * :func:`SortedList.range_sums`
+    * :func:`SortedList.range_means`
     * :func:`SortedList.find_ge`
     * :func:`SortedList.find_gt`
     * :func:`SortedList.find_le`
@@ -42,6 +109,8 @@ class SortedList(SortedContainer):
     Methods for iterating elements:
 
     * :func:`SortedList.range`
+    * :func:`SortedList.range_view`
+    * :func:`SortedList.slice_view`
     * :func:`SortedList.__iter__`
     * :func:`SortedList.__reversed__`
 
@@ -57,6 +126,7 @@ class SortedList(SortedContainer):
     Other methods:
 
     * :func:`SortedList.copy`
+    * :func:`SortedList.from_column`
     * :func:`SortedList.stats`
     * :func:`SortedList.__repr__`
 
@@ -66,6 +136,11 @@ class SortedList(SortedContainer):
             to None.
         epsilon (int, optional): space-time trade-off parameter. Defaults
             to 64.
+        compression (str, optional): storage format of the elements, one of
+            ``None``, ``'eliasfano'``, ``'residual'`` or ``'rle'``. Defaults
+            to None.
+        quantize (bool, optional): whether to quantize the index. Defaults
+            to False.
 
     Example:
         >>> from pygm import SortedList
@@ -86,8 +161,44 @@ class SortedList(SortedContainer):
         4
     """
 
-    def __init__(self, arg=None, typecode=None, epsilon=64):
-        SortedContainer._initwitharg(self, arg, typecode, epsilon, False)
+    def __init__(self, arg=None, typecode=None, epsilon=64, compression=None,
+                 quantize=False):
+        SortedContainer._initwitharg(self, arg, typecode, epsilon, False,
+                                     compression, quantize)
+
+    @classmethod
+    def from_column(cls, column, epsilon=64, compression=None,
+                    quantize=False, threads=1):
+        """Return a new ``SortedList`` with the elements of ``column``, which
+        also records the position of each element in ``column``.
+
+        The result works as a secondary index over the column, which is not
+        reordered: :func:`row_ids`, :func:`range_row_ids` and
+        :func:`equal_row_ids` return the positions in ``column`` of the
+        matching elements. The column is sorted without holding the GIL.
+
+        Args:
+            column (array-like): elements in any order, whose type gives the
+                type of the stored elements
+            epsilon (int, optional): space-time trade-off parameter. Defaults
+                to 64.
+            compression (str, optional): storage format of the elements, as
+                in :class:`SortedList`. Defaults to None.
+            quantize (bool, optional): whether to quantize the index. Defaults
+                to False.
+            threads (int, optional): number of threads used for sorting, if
+                the module was compiled with OpenMP. Defaults to 1.
+
+        Returns:
+            SortedList: new list with the elements of ``column``
+        """
+        import numpy as np
+        typecode, column = SortedContainer._typecodeofcolumn(
+            np.asarray(column))
+        impl_type = SortedContainer._classfromtypecode(typecode, compression)
+        impl = impl_type.from_column(column, False, epsilon, quantize,
+                                     threads)
+        return cls(impl, typecode)
 
     def __getitem__(self, i):
         """Return the element at position ``i``.
@@ -118,7 +229,7 @@ class SortedList(SortedContainer):
         Returns:
             SortedList: new list with the merged elements
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedList(self._impl.merge(*args), self._typecode)
 
     def __sub__(self, other):
@@ -139,7 +250,7 @@ class SortedList(SortedContainer):
         Returns:
             SortedList: new list with the elements in the difference
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedList(self._impl.difference(*args), self._typecode)
 
     def drop_duplicates(self):
@@ -12,9 +12,54 @@ class SortedSet(SortedContainer):
     standard library.  If no type code is specified, the type is inferred
     from the contents of ``arg``.
 
+    Two further type codes store 128-bit elements: ``'QQ'`` for pairs of
+    unsigned 64-bit integers such as ``(tenant_id, timestamp)``, which are
+    ordered lexicographically and returned as tuples, and ``'uint128'`` for
+    unsigned 128-bit integers such as the ``int`` attribute of UUIDs. Both
+    also accept 16 bytes in big-endian order, e.g. ``uuid.bytes``. The index
+    is built on a 64-bit projection of the elements, and these containers
+    support the methods that do not need arithmetic on the elements.
+
+    The ``'S'`` type code stores byte strings, such as ticker symbols,
+    hashes or ISO dates, one after the other in a single buffer. The index is
+    built on the 8 bytes that follow the prefix shared by all the elements,
+    and the lookups compare the full strings only near the predicted
+    position. :func:`digitize` and :func:`isin` also accept NumPy arrays of
+    fixed-length bytes, which are searched without converting each value to
+    a Python object.
+
+    NumPy arrays of ``datetime64`` or ``timedelta64`` values, or type codes
+    such as ``'M8[ns]'`` and ``'m8[s]'``, store the elements as 64-bit
+    integers in the unit of the dtype. The queries accept datetimes, strings
+    and NumPy scalars, and return elements and arrays of the same dtype;
+    arrays are viewed in place rather than converted value by value. Values
+    of a finer unit are compared exactly rather than truncated to the unit
+    of the dtype. ``NaT`` cannot be stored and raises ValueError; it is never
+    in the container.
+
     The ``epsilon`` argument allows to trade off memory usage with query
     performance. The default value is adequate in most cases.
 
+    The ``compression`` argument selects how the elements are stored. With
+    ``'eliasfano'``, integer elements are kept in Elias-Fano encoded form,
+    which takes about ``2 + log2(u/n)`` bits per element, where ``u`` is the
+    difference between the largest and the smallest element. Queries keep
+    their interface and become slightly slower because each accessed element
+    is decoded on the fly. With ``'residual'``, each segment of the index is
+    used to predict the integer elements from their positions, and only the
+    bit-packed prediction errors are stored. The smaller the ``epsilon``, the
+    smaller the errors, so this compression pays off on data that the index
+    approximates well. With ``'hybrid'``, which requires the ``'I'`` typecode
+    and uses it when no typecode is given, the elements are split into chunks
+    of 65536 consecutive values, and each chunk is automatically stored as a
+    sorted array, as a bitmap, or as a list of runs, whichever is smallest.
+    This suits sets that fill large ranges of values.
+
+    The ``quantize`` argument stores the index with single-precision slopes
+    and with 32-bit intercepts and relative keys, which makes it smaller and
+    more cache-friendly. The search range of the index is widened by the
+    rounding error, so queries stay exact.
+
     Methods for set operations:
 
     * :func:`SortedSet.difference` (alias for ``set - other``)
@@ -28,7 +73,28 @@ class SortedSet(SortedContainer):
     * :func:`SortedSet.__contains__`
     * :func:`SortedSet.bisect_left`
     * :func:`SortedSet.bisect_right`
+    * :func:`SortedSet.quantile`
+    * :func:`SortedSet.quantiles`
+    * :func:`SortedSet.cdf`
+    * :func:`SortedSet.segments`
+    * :func:`SortedSet.approx_rank`
+    * :func:`SortedSet.approx_ranks`
     * :func:`SortedSet.count`
+    * :func:`SortedSet.nearest`
+    * :func:`SortedSet.nearest_many`
+    * :func:`SortedSet.asof`
+    * :func:`SortedSet.isin`
+    * :func:`SortedSet.filter_in`
+    * :func:`SortedSet.filter_out`
+    * :func:`SortedSet.window_counts`
+    * :func:`SortedSet.digitize`
+    * :func:`SortedSet.histogram`
+    * :func:`SortedSet.count_range`
+    * :func:`SortedSet.count_ranges`
+    * :func:`SortedSet.range_sum`
+    * :func:`SortedSet.range_mean`
+    * :func:`SortedSet.range_sums`
+    * :func:`SortedSet.range_means`
     * :func:`SortedSet.find_ge`
     * :func:`SortedSet.find_gt`
     * :func:`SortedSet.find_le`
@@ -48,6 +114,8 @@ class SortedSet(SortedContainer):
     Methods for iterating elements:
 
     * :func:`SortedSet.range`
+    * :func:`SortedSet.range_view`
+    * :func:`SortedSet.slice_view`
     * :func:`SortedSet.__iter__`
     * :func:`SortedSet.__reversed__`
 
@@ -63,10 +131,17 @@ class SortedSet(SortedContainer):
             to None.
         epsilon (int, optional): space-time trade-off parameter. Defaults
             to 64.
+        compression (str, optional): storage format of the elements, one of
+            ``None``, ``'eliasfano'``, ``'residual'`` or ``'hybrid'``.
+            Defaults to None.
+        quantize (bool, optional): whether to quantize the index. Defaults
+            to False.
     """
 
-    def __init__(self, arg=None, typecode=None, epsilon=64):
-        SortedContainer._initwitharg(self, arg, typecode, epsilon, True)
+    def __init__(self, arg=None, typecode=None, epsilon=64, compression=None,
+                 quantize=False):
+        SortedContainer._initwitharg(self, arg, typecode, epsilon, True,
+                                     compression, quantize)
 
     def __getitem__(self, i):
         """Return the element at position ``i``.
@@ -97,7 +172,7 @@ class SortedSet(SortedContainer):
         Returns:
             SortedSet: new set with the elements in the union
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedSet(self._impl.union(*args), self._typecode)
 
     __or__ = union
@@ -117,7 +192,7 @@ class SortedSet(SortedContainer):
         Returns:
             SortedSet: new set with the elements in the difference
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedSet(self._impl.difference(*args), self._typecode)
 
     __sub__ = difference
@@ -137,7 +212,7 @@ class SortedSet(SortedContainer):
         Returns:
             SortedSet: new set with the elements in the symmetric difference
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedSet(self._impl.symmetric_difference(*args), self._typecode)
 
     __xor__ = symmetric_difference
@@ -157,7 +232,7 @@ class SortedSet(SortedContainer):
         Returns:
             SortedSet: new set with the elements in the intersection
         """
-        args = SortedContainer._impl_or_iter(other)
+        args = self._impl_or_iter(other)
         return SortedSet(self._impl.intersection(*args), self._typecode)
 
     __and__ = intersection
@@ -189,7 +264,7 @@ class SortedSet(SortedContainer):
         if isinstance(other, (SortedSet, set)):
             if len(self) != len(other):
                 return False
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.equal_to(*args)
         return NotImplemented
 
@@ -210,7 +285,7 @@ class SortedSet(SortedContainer):
         if isinstance(other, (SortedSet, set)):
             if len(self) != len(other):
                 return True
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.not_equal_to(*args)
         return NotImplemented
 
@@ -229,7 +304,7 @@ class SortedSet(SortedContainer):
             bool: ``True`` if sorted set is a proper subset of ``other``
         """
         if isinstance(other, (SortedSet, set)):
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.subset(*args, True)
         return NotImplemented
 
@@ -248,7 +323,7 @@ class SortedSet(SortedContainer):
             bool: ``True`` if sorted set is a proper superset of ``other``
         """
         if isinstance(other, (SortedSet, set)):
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.superset(*args, True)
         return NotImplemented
 
@@ -268,7 +343,7 @@ class SortedSet(SortedContainer):
             bool: ``True`` if sorted set is a subset of ``other``
         """
         if isinstance(other, (SortedSet, set)):
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.subset(*args, False)
         return NotImplemented
 
@@ -288,7 +363,7 @@ class SortedSet(SortedContainer):
             bool: ``True`` if sorted set is a superset of ``other``
         """
         if isinstance(other, (SortedSet, set)):
-            args = SortedContainer._impl_or_iter(other)
+            args = self._impl_or_iter(other)
             return self._impl.superset(*args, False)
         return NotImplemented
 
@@ -0,0 +1,77 @@
+from .sortedcontainer import SortedContainer
+from .sortedlist import SortedList
+
+
+class SortedView(SortedContainer):
+    """A read-only view of consecutive elements of a sorted container.
+
+    Views are returned by the ``slice_view`` and ``range_view`` methods of
+    :class:`SortedList` and :class:`SortedSet`, and by slicing a view with
+    step 1. A view shares the elements and the index of its container, and
+    it keeps the container alive, so it takes constant space regardless of
+    the number of its elements. The queries on a view cost as much as on
+    the whole container.
+
+    Methods for accessing and querying elements:
+
+    * :func:`SortedView.__getitem__`
+    * :func:`SortedView.__contains__`
+    * :func:`SortedView.bisect_left`
+    * :func:`SortedView.bisect_right`
+    * :func:`SortedView.count`
+    * :func:`SortedView.find_ge`
+    * :func:`SortedView.find_gt`
+    * :func:`SortedView.find_le`
+    * :func:`SortedView.find_lt`
+    * :func:`SortedView.index`
+    * :func:`SortedView.rank`
+
+    Methods for iterating elements:
+
+    * :func:`SortedView.range`
+    * :func:`SortedView.__iter__`
+    * :func:`SortedView.__reversed__`
+
+    Methods for narrowing the view:
+
+    * :func:`SortedView.range_view`
+    * :func:`SortedView.slice_view`
+
+    Example:
+        >>> from pygm import SortedList
+        >>> sl = SortedList(range(0, 1000, 10))
+        >>> v = sl.range_view(100, 200)
+        >>> v
+        SortedView([100, 110, 120, ..., 190, 200])
+        >>> v.rank(150)                                     # elements <= 150
+        6
+        >>> v[2:4]                                          # still a view
+        SortedView([120, 130])
+    """
+
+    def __init__(self, impl, typecode):
+        self._impl = impl
+        self._typecode = typecode
+
+    def __getitem__(self, i):
+        """Return the element at position ``i``.
+
+        ``self.__getitem__(i)`` <==> ``self[i]``
+
+        Slices with step 1 return a :class:`SortedView`, other slices return
+        a new :class:`SortedList`.
+
+        Args:
+            i (int or slice): index of the element
+
+        Returns:
+            element at position ``i``
+        """
+        if isinstance(i, slice):
+            if i.step is None or i.step == 1:
+                return self.slice_view(i.start, i.stop)
+            return SortedList(self._impl.slice(i), self._typecode)
+        return self._impl[i]
+
+    __eq__ = SortedList.__eq__
+    __ne__ = SortedList.__ne__
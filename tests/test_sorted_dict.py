@@ -0,0 +1,82 @@
+import pytest
+from pygm import SortedDict, SortedSet
+
+np = pytest.importorskip('numpy')
+
+
+def test_init():
+    assert dict(SortedDict()) == {}
+    assert dict(SortedDict({3: 'c', 1: 'a'})) == {1: 'a', 3: 'c'}
+    assert dict(SortedDict([(2, 20), (1, 10), (2, 21)])) == {1: 10, 2: 21}
+    sd = SortedDict([3., 1., 2., 1.], values=[30, 10, 20, 11])
+    assert list(sd) == [1., 2., 3.] and sd.values().tolist() == [11, 20, 30]
+    assert SortedDict(sd) == sd
+    with pytest.raises(ValueError):
+        SortedDict([1, 2], values=[1])
+
+
+def test_getitem():
+    keys = np.arange(0, 1000, 3)
+    sd = SortedDict(keys[::-1], values=keys[::-1] * 2, compression='eliasfano')
+    assert len(sd) == len(keys)
+    assert sd[9] == 18 and 9 in sd and 10 not in sd
+    assert sd.get(10) is None and sd.get(10, -1) == -1
+    with pytest.raises(KeyError):
+        sd[10]
+    with pytest.raises(ValueError):
+        sd.values()[0] = 1
+
+
+def test_get_many():
+    sd = SortedDict([5, 1, 3], values=[[50, 5], [10, 1], [30, 3]])
+    assert sd.get_many([3, 1]).tolist() == [[30, 3], [10, 1]]
+    assert sd.get_many([3, 4], default=0).tolist() == [[30, 3], [0, 0]]
+    with pytest.raises(KeyError):
+        sd.get_many([3, 4])
+    assert SortedDict().get_many([1], default=0).shape == (1,)
+    assert sd.get_many([1.5, 5.0, 2 ** 40 + 5], default=0).tolist() == \
+        [[0, 0], [50, 5], [0, 0]]
+    with pytest.raises(KeyError):
+        sd.get_many([1.5])
+    small = SortedDict(np.array([1, 2], np.uint8), values=[10, 20])
+    assert small.get_many(np.array([257, 2]), default=0).tolist() == [0, 20]
+
+
+def test_range_items():
+    sd = SortedDict(range(10), values=np.arange(10) * 10)
+    keys, values = sd.range_items(3, 6, inclusive=(False, True))
+    assert keys.tolist() == [4, 5, 6] and values.tolist() == [40, 50, 60]
+    assert sd.range_items(b=1)[1].tolist() == [0, 10]
+    assert sd.range_items(8)[0].tolist() == [8, 9]
+    assert sd.range_items(6, 3)[0].tolist() == []
+    assert isinstance(sd.keys(), SortedSet)
+
+
+def test_set_operations():
+    a = SortedDict({1: 10, 2: 20, 3: 30})
+    b = SortedDict({3: 31, 4: 41})
+    assert dict(a | b) == {1: 10, 2: 20, 3: 31, 4: 41}
+    assert dict(b | a) == {1: 10, 2: 20, 3: 30, 4: 41}
+    assert dict(a & b) == {3: 30}
+    assert dict(a - b) == {1: 10, 2: 20}
+    assert dict(a ^ b) == {1: 10, 2: 20, 4: 41}
+    assert dict(a.intersection([2, 5])) == {2: 20}
+    assert dict(a.difference(SortedSet([1, 3]))) == {2: 20}
+    assert dict(a.union({0: 0})) == {0: 0, 1: 10, 2: 20, 3: 30}
+
+
+def test_repr_and_stats():
+    assert repr(SortedDict({2: 1.5, 1: 0.5})) == 'SortedDict({1: 0.5, 2: 1.5})'
+    assert '...' in repr(SortedDict(range(10), values=range(10)))
+    assert SortedDict(range(10), values=np.zeros(10)).stats()['values size'] == 80
+
+
+def test_datetime_keys():
+    keys = np.array(['2024-03-01', '2024-01-01', '2024-02-01'], 'M8[D]')
+    sd = SortedDict(keys, values=[3, 1, 2])
+    assert sd['2024-02-01'] == 2 and np.datetime64('2024-01-01') in sd
+    assert sd.keys().stats()['typecode'] == 'M8[D]'
+    assert sd.get_many(keys).tolist() == [3, 1, 2]
+    assert sd.range_items('2024-01-15')[0].dtype == keys.dtype
+    other = SortedDict({np.datetime64('2024-04-01', 'D'): 4})
+    assert len(sd | other) == 4 and (sd - keys[:1]).values().tolist() == [1, 2]
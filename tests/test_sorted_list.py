@@ -1,9 +1,11 @@
 import bisect
+import math
 import random
+import sys
 from array import array
 
 import pytest
-from pygm import SortedList
+from pygm import SortedList, SortedView
 
 
 def test_len():
@@ -19,6 +21,9 @@ def test_init():
     assert SortedList({1: 'a', 2: 'b', 3: 'c'}) == [1, 2, 3]
     assert SortedList({1, 5, 5, 10}) == [1, 5, 10]
     assert SortedList(range(5, 0, -1)) == [1, 2, 3, 4, 5]
+    assert SortedList(x for x in (3, 1.5, 2)) == [1.5, 2, 3]
+    assert SortedList(iter([(2, 1), (1, 2)])) == [(1, 2), (2, 1)]
+    assert SortedList(x for x in (b'b', b'a')) == [b'a', b'b']
     assert SortedList({1, 5, 5, 10}, 'f') == [1., 5., 10.]
     assert SortedList(array('f', (1, 2, 2, 3))) == [1., 2., 2., 3.]
     assert SortedList(array('d', (1, 2, 2, 3))) == [1., 2., 2., 3.]
@@ -34,6 +39,33 @@ def test_init():
         SortedList("ciao")
 
 
+def test_small_types():
+    random.seed(42)
+    for typecode, lo, hi in [('b', -128, 127), ('B', 0, 255),
+                             ('h', -2 ** 15, 2 ** 15 - 1), ('H', 0, 2 ** 16 - 1)]:
+        l = sorted([random.randint(lo, hi) for _ in range(1000)] + [lo, hi])
+        sl = SortedList(l, typecode)
+        assert sl == l
+        assert sl.stats()['typecode'] == typecode
+        for x in [lo, lo + 1, 0, hi - 1, hi]:
+            assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+            assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+            assert sl.count(x) == l.count(x)
+        for x in [lo - 1, hi + 1, -2 ** 40, 2 ** 40]:
+            assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+            assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+            assert sl.count(x) == 0 and x not in sl
+            with pytest.raises(ValueError):
+                sl.index(x)
+        assert sl.find_lt(hi + 1) == hi and sl.find_gt(hi + 1) is None
+        assert sl.find_ge(lo - 1) == lo and sl.find_le(lo - 1) is None
+        assert sl.count_range(lo - 300, hi + 300) == len(l)
+        assert list(sl.range(hi, hi + 300)) == [x for x in l if x == hi]
+    assert SortedList(array('B', (1, 2, 2, 3))).stats()['data size'] < \
+        SortedList(array('I', (1, 2, 2, 3))).stats()['data size']
+    assert SortedList([1, 2, 2], 'H', compression='eliasfano') == [1, 2, 2]
+
+
 def test_compare():
     assert not SortedList([1] * 10) == SortedList([1] * 100)
     assert SortedList([-5, -4, -3, -2, -1]) > SortedList([-10, -5])
@@ -131,6 +163,227 @@ def test_count():
         assert l.count(2 ** x) == 100
 
 
+def test_quantiles():
+    l = SortedList([4, 1, 3, 2, 5, 10])
+    assert l.quantile(0) == 1
+    assert l.quantile(1) == 10
+    assert l.quantile(0.5) == 3.5
+    assert l.quantile(0.9) == 7.5
+    with pytest.raises(ValueError):
+        l.quantile(1.5)
+    with pytest.raises(ValueError):
+        SortedList().quantile(0.5)
+
+    np = pytest.importorskip('numpy')
+    qs = [0, 0.25, 0.5, 0.9, 1]
+    assert np.allclose(l.quantiles(qs), np.quantile(list(l), qs))
+    assert l.cdf([0, 1, 3, 3.5, 100]).tolist() == [0, 1 / 6, 3 / 6, 3 / 6, 1]
+
+    l = SortedList([x * x for x in range(10000)])
+    keys, slopes, intercepts = l.segments()
+    assert len(keys) == len(slopes) == len(intercepts) == l.stats()['leaf segments']
+    assert keys[0] == l[0] and all(np.diff(keys) > 0)
+    xs = np.arange(0, 10 ** 8, 12345)
+    assert np.allclose(l.cdf(xs, approximate=True), l.cdf(xs), atol=2 * l.stats()['epsilon'] / len(l))
+
+    # the batch is compared exactly with the elements, as the scalar queries
+    u = SortedList([x * x for x in range(10000)], typecode='I')
+    xs = [-1, 0, 50, 2 ** 32 - 1, 2 ** 40]
+    assert u.cdf(xs).tolist() == [u.rank(x) / len(u) for x in xs]
+    assert u.cdf(xs, approximate=True).tolist() == [u.approx_rank(x)[0] / len(u) for x in xs]
+    assert u.cdf([-0.5, 48.5]).tolist() == [0, u.rank(48) / len(u)]
+
+
+def test_approx_rank():
+    l = SortedList([x * x for x in range(10000)])
+    for x in [-1, 0, 1, 50, 12345, 10 ** 8, 10 ** 9]:
+        pos, lo, hi = l.approx_rank(x)
+        assert lo <= l.bisect_left(x) <= hi
+        assert lo <= pos <= hi and hi - lo <= 4 * l.stats()['epsilon']
+    assert SortedList().approx_rank(1) == (0, 0, 0)
+
+    np = pytest.importorskip('numpy')
+    xs = np.array([5, 500, 50000])
+    pos, lo, hi = l.approx_ranks(xs)
+    exact = [l.bisect_left(x) for x in xs.tolist()]
+    assert all(lo <= exact) and all(exact <= hi)
+
+    # the batch is compared exactly with the elements, as the scalar query
+    u = SortedList([x * x for x in range(10000)], typecode='I')
+    xs = [-1, 0, 50, 2 ** 32 - 1, 2 ** 40]
+    batch = lambda xs: list(zip(*(r.tolist() for r in u.approx_ranks(xs))))
+    assert batch(xs) == [u.approx_rank(x) for x in xs]
+    assert batch([-0.5, 48.5, 2.0 ** 40]) == [u.approx_rank(x) for x in (0, 49, 2 ** 40)]
+
+
+def test_nearest():
+    np = pytest.importorskip('numpy')
+    l = SortedList([1, 4, 6, 7, 10, 20])
+    pos, keys = l.nearest(5, 3)
+    assert pos.tolist() == [1, 2, 3]
+    assert keys.tolist() == [4, 6, 7]
+    assert l.nearest(100, 2)[1].tolist() == [20, 10]
+    assert l.nearest(-5)[1].tolist() == [1]
+    assert len(l.nearest(5, 100)[0]) == 6
+    pos, keys = l.nearest_many([0, 9, 15], 2)
+    assert keys.shape == (3, 2)
+    assert keys.tolist() == [[1, 4], [10, 7], [10, 20]]
+    assert l[2:].nearest(5, 1)[1].tolist() == [6]
+
+    # the batch is compared exactly with the elements, as the scalar query
+    u = SortedList([1, 4, 6, 7, 10, 20], typecode='I')
+    xs = [-1, 0, 5, 2 ** 32 - 1, 2 ** 40]
+    pos, keys = u.nearest_many(xs, 3)
+    assert pos.tolist() == [u.nearest(x, 3)[0].tolist() for x in xs]
+    assert u.nearest_many([5.5, -0.5], 2)[1].tolist() == [[6, 4], [1, 4]]
+
+
+def test_asof():
+    np = pytest.importorskip('numpy')
+    l = SortedList([10, 20, 30, 40])
+    values = [5, 10, 14, 16, 25, 40, 45]
+    pos, keys = l.asof(values)
+    assert pos.tolist() == [-1, 0, 0, 0, 1, 3, 3]
+    assert keys.tolist() == [0, 10, 10, 10, 20, 40, 40]
+    pos, keys = l.asof(values, 'forward')
+    assert pos.tolist() == [0, 0, 1, 1, 2, 3, -1]
+    pos, keys = l.asof(values, 'nearest')
+    assert keys.tolist() == [10, 10, 10, 20, 20, 40, 40]
+    pos, keys = l.asof(values, 'nearest', tolerance=4)
+    assert pos.tolist() == [-1, 0, 0, 1, -1, 3, -1]
+    pos, keys = l.asof(values[::-1], 'backward', tolerance=5)
+    assert pos.tolist() == [3, 3, 1, -1, 0, 0, -1]
+    with pytest.raises(ValueError):
+        l.asof(values, 'sideways')
+
+    # the values are compared exactly with the elements, as in the scalar searches
+    u = SortedList([10, 20, 30, 40], typecode='I')
+    xs = [-1, 0, 10, 25, 2 ** 32 - 1, 2 ** 40]
+    for direction, find in (('backward', u.find_le), ('forward', u.find_ge)):
+        pos, keys = u.asof(xs, direction)
+        assert [k if p >= 0 else None for p, k in zip(pos.tolist(), keys.tolist())] == [find(x) for x in xs]
+    pos, keys = u.asof([-0.5, 14.5, 15.5, 45.5], 'nearest', tolerance=5)
+    assert pos.tolist() == [-1, 0, 1, -1]
+
+
+def test_window_counts():
+    np = pytest.importorskip('numpy')
+    l = SortedList([1, 2, 2, 5, 9, 10, 20])
+    xs = [0, 2, 7, 10, 30]
+    assert l.window_counts(xs, 1).tolist() == [1, 3, 0, 2, 0]
+    assert l.window_counts(xs, 0, 3).tolist() == [3, 3, 2, 1, 0]
+    assert l.window_counts(xs[::-1], 3).tolist() == [0, 2, 3, 4, 3]
+    l = SortedList([0, 2 ** 64 - 1], typecode='Q')
+    assert l.window_counts([0, 2 ** 64 - 1], 2 ** 64 - 1).tolist() == [2, 2]
+
+    # the batch is compared exactly with the elements, as the scalar count_range
+    u = SortedList([1, 2, 2, 5, 9, 10, 20], typecode='I')
+    xs = [-1, 0, 7, 2 ** 32 + 1, 2 ** 40]
+    assert u.window_counts(xs, 2, 3).tolist() == [u.count_range(x - 2, x + 3) for x in xs]
+    assert u.window_counts([1.5, 7.5, -0.5], 1).tolist() == [3, 0, 0]
+
+
+def test_from_column():
+    np = pytest.importorskip('numpy')
+    column = np.array([30, 10, 20, 10, 50, 20, 10], dtype=np.int32)
+    for threads in (1, 3):
+        l = SortedList.from_column(column, threads=threads)
+        assert list(l) == sorted(column.tolist())
+        assert l.row_ids().tolist() == np.argsort(column, kind='stable').tolist()
+    assert l.stats()['typecode'] == column.dtype.char
+    assert l.equal_row_ids(10).tolist() == [1, 3, 6]
+    assert l.equal_row_ids(40).tolist() == []
+    assert l.range_row_ids(15, 30).tolist() == [2, 5, 0]
+    assert l.range_row_ids(10, 30, inclusive=(False, False)).tolist() == [2, 5]
+    assert l.slice_view(3).equal_row_ids(20).tolist() == [2, 5]
+    with pytest.raises(ValueError):
+        SortedList([1, 2]).row_ids()
+
+
+def test_digitize():
+    np = pytest.importorskip('numpy')
+    edges = [0, 1, 2, 2, 4, 8, 16]
+    l = SortedList(edges)
+    values = np.array([-1, 0, 1, 2, 3, 4, 15, 16, 17])
+    for right in (False, True):
+        assert l.digitize(values, right).tolist() == np.digitize(values, edges, right).tolist()
+    assert l.digitize(values, threads=4).tolist() == np.digitize(values, edges).tolist()
+    assert l.histogram(values).tolist() == np.histogram(values, edges)[0].tolist()
+    assert l.histogram(values, threads=2).tolist() == np.histogram(values, edges)[0].tolist()
+    assert SortedList([1]).histogram(values).tolist() == []
+    with pytest.raises(ValueError):
+        l.digitize(values, threads=0)
+
+    # the values are compared exactly with integer edges, neither wrapped nor truncated
+    values = np.array([-2 ** 40, -1, -0.5, 0, 0.5, 1.5, 2, 2.5, 3.99, 16, 16.5, 2 ** 40, np.nan])
+    for typecode in ('i', 'I', 'q', 'Q'):
+        l = SortedList(edges, typecode=typecode)
+        for right in (False, True):
+            assert l.digitize(values, right).tolist() == np.digitize(values, edges, right).tolist()
+            assert l.digitize(values[:-1].astype(int), right).tolist() == \
+                np.digitize(values[:-1].astype(int), edges, right).tolist()
+        assert l.histogram(values).tolist() == np.histogram(values[:-1], edges)[0].tolist()
+
+
+def test_count_range():
+    l = SortedList([1, 2, 4, 8, 16, 32] * 10)
+    assert l.count_range(2, 16) == 40
+    assert l.count_range(2, 16, inclusive=(False, False)) == 20
+    assert l.count_range(3, 100) == 40
+    assert l.count_range(16, 2) == 0
+    assert l.count_range(-5, 0) == 0
+    assert SortedList().count_range(0, 10) == 0
+
+    np = pytest.importorskip('numpy')
+    counts = l.count_ranges([2, 3, 16], [16, 100, 2], inclusive=(True, False))
+    assert isinstance(counts, np.ndarray)
+    assert counts.tolist() == [30, 40, 0]
+    with pytest.raises(ValueError):
+        l.count_ranges([1, 2], [3])
+
+    # the bounds are compared exactly, neither wrapped nor truncated
+    u = SortedList([1, 2, 3, 4, 5, 2 ** 32 - 1], typecode='I')
+    starts = [-1, -2.0 ** 70, 2.5, 1.5, 0, 2 ** 40, -1.5]
+    ends = [5, 2.0 ** 64, 4.5, 3.5, 2 ** 40, 2 ** 41, -0.5]
+    expected = [5, 6, 2, 2, 6, 0, 0]
+    assert u.count_ranges(starts, ends).tolist() == expected
+    assert u.count_ranges([-1, 0], [5, 2 ** 40]).tolist() == [5, 6]
+    assert u.count_ranges(np.array([-1], np.int8), [5]).tolist() == [5]
+    assert u.count_ranges([2.5], [4.5], inclusive=(False, False)).tolist() == [2]
+    assert u.range_sums([-1, 2.5], [4.5, 2.0 ** 64]).tolist() == [10, 2 ** 32 + 11]
+
+
+def test_range_sum():
+    l = SortedList([1, 2, 4, 8, 16, 32] * 10)
+    assert l.range_sum(2, 16) == 300
+    assert l.range_sum(2, 16, inclusive=(False, False)) == 120
+    assert l.range_sum(16, 2) == 0
+    assert l.range_mean(2, 16) == 7.5
+    assert math.isnan(l.range_mean(100, 200))
+
+    l = SortedList([2 ** 63 - 1] * 4, typecode='q')
+    assert l.range_sum(0, 2 ** 63 - 1) == 4 * (2 ** 63 - 1)
+
+    np = pytest.importorskip('numpy')
+    l = SortedList(range(100))
+    assert l.range_sums([0, 10, 50], [9, 19, 10]).tolist() == [45, 145, 0]
+    means = l.range_means([0, 10, 50], [9, 19, 10], inclusive=(True, False))
+    assert means[:2].tolist() == [4, 14] and np.isnan(means[2])
+    with pytest.raises(ValueError):
+        l.range_sums([1, 2], [3])
+
+    # the sums of 64-bit keys are exact, as the scalar ones
+    for typecode, keys in (('q', [2 ** 53 + 1, 2 ** 53 + 3, -2 ** 53 - 5]),
+                           ('Q', [2 ** 53 + 1, 2 ** 53 + 3, 2 ** 54 + 1])):
+        l = SortedList(keys, typecode=typecode)
+        starts, ends = [min(keys), 2 ** 53 + 2], [max(keys), 2 ** 55]
+        sums = l.range_sums(starts, ends)
+        assert sums.dtype == np.dtype(typecode)
+        assert sums.tolist() == [l.range_sum(a, b) for a, b in zip(starts, ends)]
+    l = SortedList([2 ** 63 - 1] * 4, typecode='q')
+    assert l.range_sums([0, 2 ** 62], [2 ** 63 - 1, 2 ** 63 - 1]).tolist() == [4 * (2 ** 63 - 1)] * 2
+
+
 def test_range():
     l = SortedList(range(0, 100, 2))
     assert list(l.range(10, 20, (False, False))) == [12, 14, 16, 18]
@@ -172,3 +425,264 @@ def test_drop_duplicates():
 def test_copy():
     assert len(SortedList().copy()) == 0
     assert SortedList([4, 1, 3, 3, 2]).copy() == [1, 2, 3, 3, 4]
+
+
+def test_compression():
+    random.seed(42)
+    l = sorted([random.randint(-1000, 1000) for _ in range(1000)])
+    for compression in ['eliasfano', 'residual']:
+        sl = SortedList(l, compression=compression)
+        assert sl == l
+        assert sl[-1] == l[-1]
+        for x in range(-1005, 1005, 7):
+            assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+            assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+            assert sl.count(x) == l.count(x)
+        assert list(sl.range(-10, 10)) == [x for x in l if -10 <= x <= 10]
+        assert sl + SortedList([5, 1]) == sorted(l + [5, 1])
+        assert SortedList(compression=compression) == []
+
+    l = [i * 1000 + random.randint(0, 15) for i in range(10000)]
+    sl = SortedList(l, 'q', 16, 'residual')
+    assert sl == l
+    assert sl.stats()['data size'] < 4 * len(l)
+    with pytest.raises(TypeError):
+        SortedList([1.5], compression='eliasfano')
+    with pytest.raises(ValueError):
+        SortedList([1], compression='zip')
+
+
+def test_rle():
+    l = sorted([0, 1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233] * 1000)
+    sl = SortedList(l, compression='rle')
+    assert sl == l
+    assert sl.count(1) == 2000
+    assert sl.rank(4) == 5000
+    assert sl.bisect_left(5) == 5000
+    assert sl.bisect_right(233) == len(l)
+    assert sl[4999] == 3 and sl[5000] == 5 and sl[-1] == 233
+    assert sl.index(8) == 6000
+    assert sl.find_lt(144) == 89
+    assert sl.drop_duplicates() == sorted(set(l))
+    assert sl.stats()['data size'] < len(l)
+    assert SortedList([1.5, 1.5, 0.5], compression='rle') == [0.5, 1.5, 1.5]
+
+
+def test_quantize():
+    random.seed(42)
+    l = sorted([random.randint(-10**12, 10**12) for _ in range(10000)] * 2)
+    for typecode in ['q', 'd']:
+        sl = SortedList(l, typecode, 16, quantize=True)
+        assert sl.stats()['quantized']
+        assert sl.stats()['index size'] < SortedList(l, typecode, 16).stats()['index size']
+        for x in l[::37] + [-10**13, 10**13]:
+            assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+            assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+        assert (sl + [0]).stats()['quantized']
+    assert not SortedList(l).stats()['quantized']
+
+
+def test_quantize_error_bound():
+    np = pytest.importorskip('numpy')
+    random.seed(42)
+    for n in [100, 200000]:
+        l = sorted(random.sample(range(2 ** 32), n))
+        for typecode in ['I', 'q', 'd']:
+            sl = SortedList(l, typecode, 16, quantize=True)
+            stats = sl.stats()
+            assert stats['quantized'] and (n < 1000 or stats['height'] > 1)
+            keys = np.asarray(sl)
+            pos, lo, hi = sl.approx_ranks(keys)
+            error = np.abs(pos.astype(np.int64) - np.arange(n))
+            assert error.max() <= stats['epsilon'] + stats['quantization error']
+            assert np.all(lo <= np.arange(n)) and np.all(np.arange(n) <= hi)
+
+
+def test_large_keys():
+    random.seed(42)
+    for typecode, lo, hi in [('q', -2**63, 2**63 - 1), ('Q', 2**63, 2**64 - 1)]:
+        l = sorted(random.randint(lo, hi) for _ in range(10000))
+        sl = SortedList(l, typecode, 16)
+        for x in l[::17] + [lo, hi]:
+            assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+            assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+
+
+def test_wide_keys():
+    random.seed(42)
+    l = sorted(random.randrange(2**128) >> random.choice((0, 64, 120))
+               for _ in range(10000))
+    l += l[:100]
+    l.sort()
+    sl = SortedList(l, 'uint128', 16)
+    assert list(sl) == l and sl[-1] == l[-1]
+    for x in l[::17] + [0, 2**128 - 1]:
+        assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+        assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+        assert sl.count(x) == l.count(x)
+    assert sl.find_le(l[5].to_bytes(16, 'big')) == l[5]
+    with pytest.raises(OverflowError):
+        sl.bisect_left(2**128)
+    assert len(sl.drop_duplicates()) == len(set(l))
+
+
+def test_byte_keys():
+    random.seed(42)
+    l = sorted(b'2024-%02d-%02d' % (random.randint(1, 12), random.randint(1, 28))
+               for _ in range(5000))
+    sl = SortedList(l)
+    assert sl.stats()['typecode'] == 'S'
+    assert list(sl) == l and sl[0] == l[0]
+    for x in l[::37] + [b'', b'2024', b'2024-06-15\x00', b'\xff']:
+        assert sl.bisect_left(x) == bisect.bisect_left(l, x)
+        assert sl.bisect_right(x) == bisect.bisect_right(l, x)
+    assert sl.count(b'2024-03-03') == l.count(b'2024-03-03')
+    with pytest.raises(TypeError):
+        sl.bisect_left('2024-03-03')
+    np = pytest.importorskip('numpy')
+    values = np.array([b'2024-01-01', b'2025', b'2024-06'])
+    assert sl.digitize(values).tolist() == [bisect.bisect_right(l, x) for x in values]
+    assert SortedList(values).stats()['typecode'] == 'S'
+
+
+def test_datetime_keys():
+    np = pytest.importorskip('numpy')
+    import datetime
+    rng = np.random.default_rng(42)
+    start = np.datetime64('2024-01-01', 'ns')
+    a = start + rng.integers(0, 10**15, 5000).astype('m8[ns]')
+    sl = SortedList(a)
+    l = np.sort(a)
+    assert sl.stats()['typecode'] == 'M8[ns]' and len(sl) == len(a)
+    assert sl[0] == l[0] and sl[0].dtype == l.dtype
+    assert np.asarray(sl).dtype == l.dtype and np.array_equal(sl, l)
+    for x in (l[17], '2024-01-02', datetime.datetime(2024, 1, 3)):
+        assert sl.bisect_left(x) == np.searchsorted(l, np.datetime64(x, 'ns'))
+    assert sl.find_ge(l[17]) == l[17] and sl.find_lt(start) is None
+    assert sl.count_range('2024-01-01', '2024-01-02') == \
+        np.count_nonzero(l < np.datetime64('2024-01-02T00:00:00.000000001'))
+    assert sl[10:20].stats()['typecode'] == 'M8[ns]'
+    assert SortedList(sl[10:20]) == SortedList(l[10:20])
+    positions, keys = sl.asof([l[3] + 1], tolerance=np.timedelta64(1, 'us'))
+    assert positions.tolist() == [3] and keys[0] == l[3]
+    assert SortedList(a.tolist(), 'M8[ns]') == sl
+    assert SortedList([], 'M8[s]').stats()['typecode'] == 'M8[s]'
+    with pytest.raises(TypeError):
+        SortedList([], 'M8')
+    col = SortedList.from_column(a[::-1])
+    assert col.stats()['typecode'] == 'M8[ns]' and col[-1] == l[-1]
+    assert col.row_ids()[0] == len(a) - 1 - np.argmin(a)
+    big = np.array([2 ** 62 + 1, 2 ** 62 + 3, 2 ** 62 + 6], 'M8[ns]')
+    sl = SortedList(big)
+    assert sl.quantile(0) == big[0] and sl.quantile(1) == big[2]
+    assert sl.quantile(0.25) == big[0] + 1 and sl.quantile(0.5) == big[1]
+    assert sl.quantiles([0, 0.5, 0.75]).tolist() == \
+        np.array([big[0], big[1], big[1] + 2]).tolist()
+    assert sl.quantiles([0.5]).dtype == big.dtype
+    with pytest.raises(ValueError):
+        sl.quantile(1.5)
+    with pytest.raises(ValueError):
+        SortedList([], 'M8[ns]').quantile(0.5)
+    nat = np.datetime64('NaT', 'ns')
+    assert nat not in sl and sl.isin([nat, big[1]]).tolist() == [False, True]
+    for bad in (np.append(big, nat), [big[0], nat]):
+        with pytest.raises(ValueError):
+            SortedList(bad, 'M8[ns]')
+    with pytest.raises(ValueError):
+        SortedList.from_column(np.append(big, nat))
+    with pytest.raises(ValueError):
+        SortedList(big) + [nat]
+    assert SortedList(big) - [nat] == SortedList(big)
+
+
+def test_datetime_finer_units():
+    np = pytest.importorskip('numpy')
+    t0 = np.datetime64('2024-01-01T00:00:00', 's')
+    a = t0 + np.arange(10).astype('m8[s]')
+    sl = SortedList(a)
+    half = np.timedelta64(500, 'ms')
+    x = t0 + half
+    assert sl.find_ge(x) == sl.find_gt(x) == a[1]
+    assert sl.find_le(x) == sl.find_lt(x) == a[0]
+    assert sl.bisect_left(x) == sl.bisect_right(x) == 1
+    assert sl.bisect_left('2024-01-01T00:00:00.5') == 1
+    assert x not in sl and sl.count(x) == 0 and t0 + np.timedelta64(1000, 'ms') in sl
+    with pytest.raises(ValueError):
+        sl.index(x)
+    assert sl.count_range(x, a[2] + half) == 2
+    assert sl.count_range(x, a[3], inclusive=(False, False)) == 2
+    assert sl.count_range(a[0], x, inclusive=(True, False)) == 1
+    assert list(sl.range(x, a[3] - half)) == list(a[1:3])
+    assert sl.count_ranges([x], [a[3]], inclusive=(False, False)).tolist() == [2]
+
+    probes = np.array([x, a[2], a[9] + half, np.datetime64('NaT', 'ms')])
+    assert sl.isin(probes).tolist() == [False, True, False, False]
+    assert sl.digitize(probes[:3]).tolist() == [1, 3, 10]
+    assert sl.digitize(probes[:3], right=True).tolist() == [1, 2, 10]
+    assert sl.histogram(probes).tolist() == [1, 0, 1, 0, 0, 0, 0, 0, 0]
+    assert sl.cdf(probes[:3]).tolist() == [0.1, 0.3, 1]
+    assert sl.window_counts([x, a[2]], half).tolist() == [2, 1]
+    assert sl.window_counts([x, a[2]], np.timedelta64(1, 's')).tolist() == [2, 3]
+
+    tenth = np.timedelta64(100, 'ms')
+    assert sl.nearest(a[2] + half + tenth, 2)[1].tolist() == [a[3], a[2]]
+    assert sl.nearest(a[2] + half, 2)[1].tolist() == [a[2], a[3]]
+    assert sl.nearest_many([a[2] + half + tenth, a[5]], 2)[1].tolist() == \
+        [[a[3], a[2]], [a[5], a[4]]]
+    assert sl.asof([x], 'backward')[0].tolist() == [0]
+    assert sl.asof([x], 'forward')[0].tolist() == [1]
+    assert sl.asof([x + tenth, x - tenth], 'nearest')[0].tolist() == [1, 0]
+    assert sl.asof([a[9] + half], tolerance=4 * tenth)[0].tolist() == [-1]
+    assert sl.asof([a[9] + half], tolerance=half)[0].tolist() == [9]
+
+
+def test_buffer():
+    np = pytest.importorskip('numpy')
+    l = [3, 1, 4, 1, 5, 9, 2, 6]
+    sl = SortedList(l, 'i')
+    a = np.asarray(sl)
+    assert a.dtype == np.int32 and a.tolist() == sorted(l)
+    assert not a.flags.writeable
+    assert np.asarray(sl, dtype=float).tolist() == sorted(l)
+    assert np.array(sl).flags.writeable
+    assert np.asarray(SortedList(l, compression='rle')).tolist() == sorted(l)
+    assert np.asarray(SortedList()).tolist() == []
+    if sys.version_info >= (3, 12):
+        assert memoryview(sl).tolist() == sorted(l)
+
+
+def test_views():
+    random.seed(42)
+    l = sorted([random.randint(0, 1000) for _ in range(1000)])
+    sl = SortedList(l, 'i')
+    v = sl.range_view(100, 200)
+    assert v == [x for x in l if 100 <= x <= 200]
+    assert sl.range_view(100, 200, (False, False)) == \
+        [x for x in l if 100 < x < 200]
+    assert v.rank(150) == sum(1 for x in l if 100 <= x <= 150)
+    assert v.find_lt(100) is None and v.find_gt(200) is None
+    assert (150 in v) == (150 in l)
+    assert 99 not in v and 201 not in v
+    w = sl.slice_view(10, -10)
+    assert w == l[10:-10] and w[5:20] == l[15:30]
+    assert isinstance(w[5:20], SortedView) and w[::2] == l[10:-10:2]
+    assert w.count(l[50]) == l[10:-10].count(l[50])
+    assert list(reversed(w.slice_view(0, 5))) == l[14:9:-1]
+    assert len(sl.slice_view(10, 5)) == 0
+
+
+def test_chunks():
+    np = pytest.importorskip('numpy')
+    l = sorted([random.randint(0, 10 ** 6) for _ in range(10000)])
+    for compression in [None, 'eliasfano']:
+        sl = SortedList(l, 'q', compression=compression)
+        chunks = list(sl.iter_chunks(3000))
+        assert [len(c) for c in chunks] == [3000, 3000, 3000, 1000]
+        assert all(not c.flags.writeable for c in chunks)
+        assert np.concatenate(chunks).tolist() == l
+        chunks = list(sl.range_chunks(1000, 20000, 50, (False, True)))
+        assert np.concatenate(chunks).tolist() == \
+            [x for x in l if 1000 < x <= 20000]
+    assert list(SortedList().iter_chunks()) == []
+    with pytest.raises(ValueError):
+        SortedList(l).iter_chunks(0)
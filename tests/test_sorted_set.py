@@ -178,3 +178,137 @@ def test_isdisjoint():
     assert not SortedSet({1, 2, 4, 8}).isdisjoint(SortedSet({1, 2, 4, 8}))
     assert SortedSet().isdisjoint(set())
     assert SortedSet().isdisjoint(SortedSet())
+
+
+def test_compression():
+    l = list(range(0, 10 ** 6, 3))
+    ss = SortedSet(l, 'I', compression='eliasfano')
+    assert ss.stats()['data size'] < len(l)
+    assert ss == set(l)
+    assert 999 in ss and 1000 not in ss
+    assert ss.rank(30) == 11
+    assert list(ss & SortedSet(range(0, 100, 2))) == list(range(0, 100, 6))
+    assert list(ss.union([1, 2])[:5]) == [0, 1, 2, 3, 6]
+
+
+def test_hybrid():
+    l = sorted(set(range(0, 200000, 3)) | set(range(10 ** 6, 10 ** 6 + 10 ** 5))
+               | {10 ** 7, 2 ** 32 - 1})
+    ss = SortedSet(l, 'I', compression='hybrid')
+    stats = ss.stats()
+    assert stats['bitmap chunks'] > 0 and stats['run chunks'] > 0
+    assert stats['array chunks'] > 0
+    assert stats['data size'] < len(l)
+    assert ss == set(l)
+    for x in [0, 1, 3, 199998, 10 ** 6 - 1, 10 ** 6 + 5, 10 ** 7, 2 ** 32 - 1]:
+        assert (x in ss) == (x in l)
+        assert ss.bisect_left(x) == bisect.bisect_left(l, x)
+        assert ss.bisect_right(x) == bisect.bisect_right(l, x)
+    assert ss[66667] == 10 ** 6
+    assert list(ss.range(10, 20)) == [12, 15, 18]
+    assert ss - SortedSet(range(10 ** 6), 'I') == set(l[66667:])
+    empty = SortedSet([], 'I', compression='hybrid')
+    assert len(empty) == 0 and empty.stats()['typecode'] == 'I'
+    assert 'array chunks' in empty.stats()
+    for default in (SortedSet(compression='hybrid'),
+                    SortedSet([], compression='hybrid')):
+        assert len(default) == 0 and default.stats()['typecode'] == 'I'
+    assert SortedSet([3, 1], compression='hybrid').stats()['typecode'] == 'I'
+    with pytest.raises(TypeError):
+        SortedSet([1, 2], 'q', compression='hybrid')
+    with pytest.raises(ValueError):
+        SortedList([1, 2], 'I', compression='hybrid')
+    with pytest.raises(ValueError):
+        SortedList([], 'I', compression='hybrid')
+
+
+def test_quantize():
+    random.seed(42)
+    l = sorted(set(random.randint(0, 10**9) for _ in range(10000)))
+    ss = SortedSet(l, 'I', quantize=True)
+    assert ss.stats()['quantized']
+    assert all(x in ss for x in l[::11])
+    assert (ss | [1, 2]).stats()['quantized']
+    assert list(ss & l[:100]) == l[:100]
+
+
+def test_pair_keys():
+    pairs = [(t, ts) for t in (3, 1, 2) for ts in range(1000, 0, -7)]
+    ss = SortedSet(pairs)
+    assert ss.stats()['typecode'] == 'QQ'
+    assert list(ss) == sorted(pairs)
+    assert ss.bisect_left((2, 0)) == len(ss) // 3
+    assert ss.find_gt((1, 2**64 - 1)) == (2, 6) and ss.find_lt((1, 6)) is None
+    assert (2, 13) in ss and (2, 14) not in ss
+    assert list(ss.range((1, 990), (2, 13))) == [(1, 993), (1, 1000), (2, 6), (2, 13)]
+    key = (2).to_bytes(8, 'big') + (20).to_bytes(8, 'big')
+    assert ss.index(key) == ss.index((2, 20))
+    assert list(ss & [(3, 6), (4, 6)]) == [(3, 6)]
+    assert len(ss | SortedSet([(0, 1), (1, 6)])) == len(ss) + 1
+    assert repr(ss).startswith('SortedSet([(1, 6), (1, 13), (1, 20), ...')
+
+
+def test_byte_keys():
+    ss = SortedSet([b'MSFT', b'AAPL', b'GOOG', b'AAPL', b'A', b'AMZN'])
+    assert list(ss) == [b'A', b'AAPL', b'AMZN', b'GOOG', b'MSFT']
+    assert b'GOOG' in ss and b'GOO' not in ss
+    assert ss.find_ge(b'B') == b'GOOG' and ss.find_lt(b'A') is None
+    assert list(ss - [b'A', b'MSFT']) == [b'AAPL', b'AMZN', b'GOOG']
+    assert repr(ss) == "SortedSet([b'A', b'AAPL', b'AMZN', b'GOOG', b'MSFT'])"
+    np = pytest.importorskip('numpy')
+    values = np.array([b'TSLA', b'AAPL', b'A', b'AA'])
+    for sort in (False, True):
+        assert ss.isin(values, sort).tolist() == [False, True, True, False]
+    assert ss.filter_out([b'IBM', b'AMZN']).tolist() == [b'IBM']
+    padded = SortedSet([b'ab\x00', b'ab', b'a\x00b'])
+    assert list(padded) == [b'a\x00b', b'ab', b'ab\x00'] and b'ab\x00' in padded
+    probes = [b'ab\x00', b'ab\x00\x00', b'ab', b'a']
+    assert padded.isin(probes).tolist() == [True, False, True, False]
+    assert padded.digitize(probes).tolist() == [3, 3, 2, 0]
+    assert padded.isin(np.array(probes)).tolist() == [True, True, True, False]
+
+
+def test_timedelta_keys():
+    np = pytest.importorskip('numpy')
+    a = np.array([90, 30, 60, 30, 120], 'm8[s]')
+    ss = SortedSet(a)
+    assert ss.stats()['typecode'] == 'm8[s]'
+    assert np.asarray(ss).tolist() == sorted(set(a.tolist()))
+    assert np.timedelta64(1, 'm') in ss and np.timedelta64(45, 's') not in ss
+    assert ss.find_gt(np.timedelta64(1, 'm')) == np.timedelta64(90, 's')
+    assert list(ss & SortedSet(a[:2])) == [np.timedelta64(30, 's'),
+                                           np.timedelta64(90, 's')]
+    assert ss.isin(np.array([2, 3], 'm8[m]')).tolist() == [True, False]
+
+
+def test_isin():
+    np = pytest.importorskip('numpy')
+    s = SortedSet([2, 3, 5, 7, 11, 13])
+    values = np.array([13, 1, 2, 4, 7, 7, 100])
+    expected = np.isin(values, list(s))
+    for sort in (False, True):
+        for threads in (1, 2):
+            assert s.isin(values, sort, threads).tolist() == expected.tolist()
+    assert s.filter_in(values).tolist() == [13, 2, 7, 7]
+    assert s.filter_out(values, sort=True).tolist() == [1, 4, 100]
+    assert s.filter_in(values).dtype == values.dtype
+    assert s.isin([1.5, 2.0, 3.25]).tolist() == [False, True, False]
+    assert s.filter_out(np.array([3.0, 3.5, 1e30])).tolist() == [3.5, 1e30]
+    small = SortedSet([1, 2, 3, 255], 'B')
+    wide = np.array([257, 2, -255, -1, 2 ** 40 + 3, 3], np.int64)
+    assert small.isin(wide).tolist() == [False, True, False, False, False, True]
+    assert small.filter_in(wide).tolist() == [2, 3]
+    unsigned = np.array([2 ** 64 - 1, 1], np.uint64)
+    assert SortedSet([-1, 1]).isin(unsigned).tolist() == [False, True]
+    # ints beyond the range of int64 are not rounded through floats
+    huge = SortedSet([0, 2 ** 64 - 1], 'Q')
+    assert huge.isin([2 ** 64 - 1, 2 ** 64 - 2, 0]).tolist() == [True, False, True]
+
+
+def test_views():
+    ss = SortedSet(range(0, 10 ** 6, 5), compression='eliasfano')
+    v = ss.range_view(1000, 2000, inclusive=(False, True))
+    assert list(v) == list(range(1005, 2001, 5))
+    assert v.bisect_left(1500) == 99 and v.index(1500) == 99
+    assert list(v.range_view(1500, 1510)) == [1500, 1505, 1510]
+    assert list(ss.slice_view(-3)) == [999985, 999990, 999995]